@@ -21,9 +21,21 @@ _CG_BEGIN
 
 template<typename R, typename... Args> class Function;
 template<typename K, typename V> class Map;
+template<typename K, typename V> class SortedMap;
+template<typename K, typename T> class Grouped;
+template<typename K> class Counted;
 template<typename T> class Array;
+template<typename T> class ConcurrentArray;
+template<typename T, size_t N> class FixedArray;
+template<size_t N> class FixedString;
+template<typename T, size_t N> class SmallArray;
+class BitArray;
+class InternPool;
+class Joined;
 class Printable;
 class String;
+class StringArray;
+class Symbol;
 
 //
 // All generic objects have the _Printable trait, which allows them to be passed
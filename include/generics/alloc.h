@@ -0,0 +1,70 @@
+/*
+ * Clean Generics
+ *
+ * Copyright (C) 2021-2022 bellrise
+ *
+ * Memory allocation for the String & Array buffers.
+ */
+#ifndef CG_ALLOC_H
+#define CG_ALLOC_H
+
+#include <generics.h>
+
+// Blocks up to this size (including the block header) come from the size
+// classes of the thread cache, larger ones go straight to malloc.
+#define CG_ALLOC_MAX_SMALL      32768
+
+// Size of the chunks the thread caches carve their blocks out of.
+#define CG_ALLOC_CHUNK          262144
+
+// Alignment of the memory returned by mem_alloc(). Types which need more have
+// to be allocated some other way, see Array<T>::_new_slots().
+#define CG_ALLOC_ALIGN          16
+
+// Memory mappings are multiples of the huge page size.
+#define CG_MAP_GRANULE          ((size_t) 2 << 20)
+
+_CG_BEGIN
+
+//
+// All String & Array buffers are allocated with these functions. By default
+// they are just malloc, realloc & free. When the library is built with
+// -DCG_ALLOCATOR, they use a thread-caching allocator instead:
+//
+//  - Sizes up to CG_ALLOC_MAX_SMALL are rounded up to a size class. Each
+//    thread keeps its own free list for every class, so allocating and
+//    freeing a buffer in the same thread never takes a lock.
+//  - Each block remembers the thread cache it came from. A block freed by a
+//    different thread is pushed onto a lock-free list of its owner, which
+//    the owner takes back the next time its free list of that class runs
+//    dry.
+//  - When a thread exits, its cache is kept for the next new thread, so the
+//    blocks it still owns stay valid and get reused.
+//
+// The memory is aligned to CG_ALLOC_ALIGN bytes. Memory from mem_alloc() must
+// only be resized with mem_realloc() and freed with mem_free(), never with the
+// libc functions.
+//
+void* mem_alloc(size_t bytes);
+void* mem_realloc(void* ptr, size_t bytes);
+void  mem_free(void* ptr);
+
+#ifdef __linux__
+
+//
+// Large buffers can get a private anonymous memory mapping instead. The size
+// has to be a multiple of CG_MAP_GRANULE. The mapping starts out zeroed, is
+// aligned to CG_MAP_GRANULE and asks the kernel for transparent huge pages,
+// so a large array needs far fewer TLB entries and page faults. Resizing
+// moves the page tables with mremap() instead of copying the data. These
+// return nullptr if the kernel is out of memory.
+//
+void* map_alloc(size_t bytes);
+void* map_realloc(void* ptr, size_t old_bytes, size_t bytes);
+void  map_free(void* ptr, size_t bytes);
+
+#endif
+
+_CG_END
+
+#endif /* CG_ALLOC_H */
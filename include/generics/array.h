@@ -9,14 +9,57 @@
 #define CG_ARRAY_H
 
 #include <generics/string.h>
+#include <generics/bit_array.h>
+#include <generics/hash.h>
+#include <generics/alloc.h>
 
 #include <malloc.h>
+#include <stdlib.h>
 #include <string.h>
+#include <new>
 
 #define CG_ARRAY_ALLOC_G    16
 
+// Arrays of trivial types which need at least this many bytes get their own
+// memory mapping on Linux, see Array<T>::_mapped().
+#define CG_ARRAY_MMAP_BYTES (4 << 20)
+
 _CG_BEGIN
 
+// Strip the reference & const from a type, used to find the key type from the
+// return type of a key function.
+template<typename T> struct _remove_cvref { typedef T type; };
+template<typename T> struct _remove_cvref<T&> : _remove_cvref<T> {};
+template<typename T> struct _remove_cvref<T&&> : _remove_cvref<T> {};
+template<typename T> struct _remove_cvref<T const> { typedef T type; };
+
+// Whether a String can be made out of the type, without any ambiguity between
+// the String constructors.
+template<typename T, typename = void>
+struct _has_string { static constexpr bool value = false; };
+
+template<typename T>
+struct _has_string<T, decltype((void) String(*(T const*) nullptr))>
+{ static constexpr bool value = true; };
+
+// The type of the key returned by the key function for an element of type T.
+// Named key functions are passed as references, so the reference has to be
+// removed before a pointer to the function can be formed.
+template<typename T, typename KeyFunction>
+using _key_type = typename _remove_cvref<decltype(
+    (*(typename _remove_cvref<KeyFunction>::type*) nullptr)(*(T*) nullptr))>::type;
+
+// Implementations of the hash-based operators, see generics/group.h.
+template<typename K, typename T, typename KeyFunction>
+Grouped<K, T> _group_by(T* data, size_t len, KeyFunction& key_fn);
+
+template<typename K, typename T, typename KeyFunction>
+Counted<K> _count_by(T* data, size_t len, KeyFunction& key_fn);
+
+template<typename A, typename B, typename KeyA, typename KeyB>
+Joined _hash_join(A* left, size_t left_len, B* right, size_t right_len,
+                  KeyA& key_left, KeyB& key_right);
+
 //
 // This array is a dynamic collection of elements, which you can append & remove
 // elements, sort, map, filter & reduce them. All the code needs to be in the
@@ -36,7 +79,7 @@ public:
 
     // Copy the array and create a new one. Note that this will only copy the
     // type/object fields, without deep-copying if <T> is an array for example.
-    Array(Array const& other)
+    Array(Array const& other) : m_size(0), m_len(0), m_array(nullptr)
     {
         _alloc(other.m_len);
         _copy_array<T>(other.m_array, m_array, other.m_len);
@@ -44,6 +87,16 @@ public:
         m_len = other.m_len;
     }
 
+    // Move the elements of a temporary array into a new one, without copying
+    // anything.
+    Array(Array&& other) noexcept
+        : m_size(other.m_size), m_len(other.m_len), m_array(other.m_array)
+    {
+        other.m_size  = 0;
+        other.m_len   = 0;
+        other.m_array = nullptr;
+    }
+
     // Delete the array.
     ~Array()
     {
@@ -56,6 +109,12 @@ public:
         return m_size;
     }
 
+    // Return the amount of elements in the array.
+    size_t len() const
+    {
+        return m_len;
+    }
+
     // Append an element to the array. The element will get copied.
     void append(T const& elem)
     {
@@ -95,7 +154,7 @@ public:
     // Remove all elements from the array.
     void clear()
     {
-        delete[] m_array;
+        _delete_slots(m_array, m_size);
 
         m_size  = 0;
         m_len   = 0;
@@ -117,7 +176,7 @@ public:
     // of slots requested, this function will fail. This can help is optimizing
     // the array, because the amount of slots requested is allocated once, so
     // no copying and reallocation needs to happen.
-    void set_size(size_t slots) const
+    void set_size(size_t slots)
     {
         if (m_size >= slots)
             return;
@@ -175,6 +234,49 @@ public:
         return new_array;
     }
 
+    // Call the filter function on each element, and return a bit array where
+    // bit i is set if element i passed. Unlike filter(), nothing is copied,
+    // and masks from different filters can be combined with & | ^ ~ before
+    // the elements are selected with select().
+    template<typename FilterFunction>
+    BitArray mask(FilterFunction&& filter) const
+    {
+        BitArray result;
+        size_t   i = 0;
+
+        // Build whole words locally, so each word is stored only once.
+        while (i < m_len) {
+            BitArray::word_type word = 0;
+            size_t bits = m_len - i < BitArray::word_bits
+                ? m_len - i : BitArray::word_bits;
+
+            for (size_t j = 0; j < bits; j++)
+                word |= (BitArray::word_type) !!filter(m_array[i + j]) << j;
+
+            result.append_word(word, bits);
+            i += bits;
+        }
+
+        return result;
+    }
+
+    // Return a copy of the array with only the elements which have their bit
+    // set in the mask. The mask needs to be as long as the array.
+    Array<T> select(BitArray const& mask) const
+    {
+        Array<T> new_array;
+
+        if (mask.len() != m_len)
+            throw "Mask length differs from the array length";
+
+        new_array.set_size(mask.count());
+        mask.for_each([this, &new_array] (size_t i) {
+            new_array.append(m_array[i]);
+        });
+
+        return new_array;
+    }
+
     // Reduce the array into a single value of the type. Each call of the reduce
     // function will pass the already collected value and the current value. If
     // you just want to add all the elements up, see Array<T>::sum().
@@ -197,10 +299,59 @@ public:
     template<typename ProduceFunction>
     void produce(size_t amount, ProduceFunction&& producer)
     {
+        set_size(m_len + amount);
         for (size_t i = 0; i < amount; i++)
             append(producer(i));
     }
 
+    // Group the elements by the key returned from the key function. This uses
+    // a hash table, so it takes linear time, and the key type needs a hash()
+    // overload and operator==. Groups are in the order their key first
+    // appeared, except for very large arrays, which are radix-partitioned by
+    // the hash first; see generics/group.h.
+    template<typename KeyFunction>
+    Grouped<_key_type<T, KeyFunction>, T> group_by(KeyFunction&& key_fn) const
+    {
+        return _group_by<_key_type<T, KeyFunction>>(m_array, m_len, key_fn);
+    }
+
+    // Count the elements for each key returned from the key function. See
+    // group_by() for the order of the keys.
+    template<typename KeyFunction>
+    Counted<_key_type<T, KeyFunction>> count_by(KeyFunction&& key_fn) const
+    {
+        return _count_by<_key_type<T, KeyFunction>>(m_array, m_len, key_fn);
+    }
+
+    // Return a copy of the array without duplicates, keeping the first
+    // occurrence of each element. T needs a hash() overload and operator==.
+    Array<T> distinct() const
+    {
+        HashIndex<T> index;
+        Array<T>     new_array;
+
+        for (size_t i = 0; i < m_len; i++)
+            index.insert(m_array[i]);
+
+        new_array.set_size(index.len());
+        for (size_t i = 0; i < index.len(); i++)
+            new_array.append((T&&) index.key(i));
+
+        return new_array;
+    }
+
+    // Join this array with the other one on equal keys, using a hash table
+    // built from the other array. The result holds the indices of each pair
+    // of matching elements. Large inputs are radix-partitioned first, so the
+    // hash table for each partition fits in cache.
+    template<typename E, typename KeyFunction, typename OtherKeyFunction>
+    auto hash_join(Array<E> const& other, KeyFunction&& key,
+                     OtherKeyFunction&& other_key) const
+    {
+        return _hash_join(m_array, m_len, other.begin(), other.len(), key,
+                          other_key);
+    }
+
     // Sum all the objects in the array, using a simple add lamba in reduce().
     // Note that if T does not provide a operator+ which returns a copy of
     // itself, this method will not compile.
@@ -254,6 +405,8 @@ public:
     // See Array(Array&& other) move constructor
     void operator=(Array&& other)
     {
+        clear();
+
         m_array = other.m_array;
         m_size  = other.m_size;
         m_len   = other.m_len;
@@ -265,6 +418,9 @@ public:
 
 protected:
 
+    // Small arrays can take over the storage of an array and give it back.
+    template<typename E, size_t N> friend class SmallArray;
+
     // Allocate enough slots for the elements, rounding up to the closest value
     // defined by CG_ARRAY_ALLOC_G.
     void _alloc(size_t slots)
@@ -273,21 +429,129 @@ protected:
             return;
 
         size_t alloc_size;
+        size_t old_size;
         T* old_array;
 
         alloc_size = slots - (slots % CG_ARRAY_ALLOC_G);
         alloc_size += CG_ARRAY_ALLOC_G;
 
-        m_size    = alloc_size;
+        if (_mapped(alloc_size)) {
+            size_t bytes = _map_bytes(alloc_size);
+
+            // Mapped arrays grow at least by doubling, so appending does not
+            // remap every CG_MAP_GRANULE bytes. Pages which are never written
+            // to do not take up any memory, so this costs only address space.
+            if (_mapped(m_size) && bytes < 2 * _map_bytes(m_size))
+                bytes = 2 * _map_bytes(m_size);
+
+            alloc_size = bytes / sizeof(T);
+
+            // The pages are moved to the larger mapping by the kernel, so
+            // nothing is copied and the memory is never held twice.
+            if (_mapped(m_size)) {
+                m_array = (T *) _remap(m_array, _map_bytes(m_size), bytes);
+                m_size  = alloc_size;
+                return;
+            }
+        }
+
+        old_size  = m_size;
         old_array = m_array;
-        m_array   = new T[alloc_size];
+        m_array   = _new_slots(alloc_size);
+        m_size    = alloc_size;
 
         if (old_array) {
             _copy_array<T>(old_array, m_array, m_len);
-            delete[] old_array;
+            _delete_slots(old_array, old_size);
         }
     }
 
+    // Large buffers of trivial types are stored in their own memory mapping,
+    // which can be grown with mremap() and backed by huge pages. Whether a
+    // buffer is mapped only depends on its amount of slots, so any code which
+    // knows the size of the buffer can free it correctly.
+    static constexpr bool _mapped(size_t slots)
+    {
+#ifdef __linux__
+        return __is_trivial(T) && slots * sizeof(T) >= CG_ARRAY_MMAP_BYTES;
+#else
+        (void) slots;
+        return false;
+#endif
+    }
+
+    // Return the size of the mapping for a mapped buffer.
+    static constexpr size_t _map_bytes(size_t slots)
+    {
+        return (slots * sizeof(T) + CG_MAP_GRANULE - 1) & ~(CG_MAP_GRANULE - 1);
+    }
+
+    static void* _remap(void* array, size_t old_bytes, size_t bytes)
+    {
+#ifdef __linux__
+        array = map_realloc(array, old_bytes, bytes);
+        if (!array)
+            throw "Out of memory";
+#endif
+        return array;
+    }
+
+    // Allocate the slots with mem_alloc(), so the buffers can come from the
+    // thread-caching allocator. Like new[], each slot is default-constructed.
+    // Mapped buffers start out zeroed and hold trivial types, so their pages
+    // are left untouched until they are used.
+    static T* _new_slots(size_t slots)
+    {
+        T* array;
+
+#ifdef __linux__
+        if (_mapped(slots)) {
+            array = (T *) map_alloc(_map_bytes(slots));
+            if (!array)
+                throw "Out of memory";
+            return array;
+        }
+#endif
+
+        // Over-aligned types get memory from aligned_alloc() instead, as
+        // mem_alloc() only aligns to CG_ALLOC_ALIGN bytes. The size is always
+        // a multiple of the alignment, as required by aligned_alloc().
+        if (alignof(T) > CG_ALLOC_ALIGN)
+            array = (T *) aligned_alloc(alignof(T), slots * sizeof(T));
+        else
+            array = (T *) mem_alloc(slots * sizeof(T));
+
+        if (!array)
+            throw "Out of memory";
+
+        for (size_t i = 0; i < slots; i++)
+            new (&array[i]) T;
+
+        return array;
+    }
+
+    // Destroy the slots and free the buffer from _new_slots().
+    static void _delete_slots(T* array, size_t slots)
+    {
+        if (!array)
+            return;
+
+#ifdef __linux__
+        if (_mapped(slots)) {
+            map_free(array, _map_bytes(slots));
+            return;
+        }
+#endif
+
+        for (size_t i = 0; i < slots; i++)
+            array[i].~T();
+
+        if (alignof(T) > CG_ALLOC_ALIGN)
+            free(array);
+        else
+            mem_free(array);
+    }
+
     // In order to support different types, the _copy_array method needs to
     // support a simple array copy for basic C types, and more sophisticated
     // .copy() routines for types like a String.
@@ -337,4 +601,6 @@ Array<Array<Array<T>>> deep_copy(Array<Array<Array<T>>> const& source)
 
 _CG_END
 
+#include <generics/group.h>
+
 #endif /* CG_ARRAY_H */
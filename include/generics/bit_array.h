@@ -0,0 +1,138 @@
+/*
+ * Clean Generics
+ *
+ * Copyright (C) 2021-2022 bellrise
+ *
+ * Bit array object.
+ */
+#ifndef CG_BIT_ARRAY_H
+#define CG_BIT_ARRAY_H
+
+#include <generics/string.h>
+
+_CG_BEGIN
+
+//
+// The bit array is a packed array of booleans, storing 64 of them in a single
+// word. Logical operations work on whole words, and counting the set bits uses
+// SIMD popcount when the CPU supports it. The main use is as a selection mask
+// over an Array, see Array<T>::mask() and Array<T>::select():
+//
+//  BitArray even  = numbers.mask([] (int& n) { return n % 2 == 0; });
+//  BitArray small = numbers.mask([] (int& n) { return n < 100; });
+//  Array<int> result = numbers.select(even & small);
+//
+// Bits past the length of the array are always kept at zero.
+//
+class BitArray : public Printable
+{
+public:
+    typedef unsigned long long word_type;
+
+    static constexpr size_t word_bits = sizeof(word_type) * 8;
+
+    BitArray();
+
+    // Create a bit array of `len` bits, all set to the value.
+    BitArray(size_t len, bool value);
+
+    BitArray(BitArray const& other);
+    BitArray(BitArray&& other) noexcept;
+
+    // Free the words.
+    ~BitArray();
+
+    // Return the amount of bits in the array.
+    size_t len() const;
+
+    // Append a single bit.
+    void append(bool value);
+
+    // Append a whole word of bits, starting with the lowest bit. Only the
+    // first `bits` bits of the word are used.
+    void append_word(word_type word, size_t bits);
+
+    // Get the bit at the index.
+    bool get(size_t index) const;
+
+    // Set the bit at the index to the value.
+    void set(size_t index, bool value);
+
+    // Set all bits to the value.
+    void fill(bool value);
+
+    // Remove all bits from the array.
+    void clear();
+
+    // Return the amount of set bits.
+    size_t count() const;
+
+    // Returns true if any bit is set.
+    bool any() const;
+
+    // Return the index of the first set bit at or after the index, or len() if
+    // there is none. Together with find_first(), this walks over the set bits
+    // a whole word at a time.
+    size_t find_next(size_t index) const;
+    size_t find_first() const;
+
+    // Call the function with the index of each set bit, in order.
+    template<typename IndexFunction>
+    void for_each(IndexFunction&& func) const
+    {
+        for (size_t i = 0; i < m_words; i++) {
+            word_type word = m_bits[i];
+
+            while (word) {
+                func(i * word_bits + __builtin_ctzll(word));
+                word &= word - 1;
+            }
+        }
+    }
+
+    // Flip all bits.
+    void invert();
+
+    // Return the underlying words, for custom word-level operations. The bit
+    // at index i is bit (i % 64) of word (i / 64).
+    word_type const* words() const;
+    size_t word_count() const;
+
+    // Return the bits as a list of 0s and 1s.
+    String as_string() const override;
+
+    // Get the bit at the index.
+    bool operator[](size_t index) const;
+
+    // Word-level operations. Both arrays need to have the same length.
+    BitArray operator&(BitArray const& other) const;
+    BitArray operator|(BitArray const& other) const;
+    BitArray operator^(BitArray const& other) const;
+    BitArray operator~() const;
+
+    void operator&=(BitArray const& other);
+    void operator|=(BitArray const& other);
+    void operator^=(BitArray const& other);
+
+    void operator=(BitArray const& other);
+    void operator=(BitArray&& other);
+
+private:
+    size_t      m_len;
+    size_t      m_words;
+    size_t      m_size;
+    word_type*  m_bits;
+
+    // Make room for at least `words` words. The capacity grows by doubling,
+    // so appending single bits stays cheap.
+    void _alloc(size_t words);
+
+    // Clear the unused bits in the last word.
+    void _mask_tail();
+
+    void _check_len(BitArray const& other) const;
+};
+
+_CG_END
+
+#endif /* CG_BIT_ARRAY_H */
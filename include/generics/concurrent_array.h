@@ -0,0 +1,202 @@
+/*
+ * Clean Generics
+ *
+ * Copyright (C) 2021-2022 bellrise
+ *
+ * Concurrent append-only array object.
+ */
+#ifndef CG_CONCURRENT_ARRAY_H
+#define CG_CONCURRENT_ARRAY_H
+
+#include <generics/string.h>
+#include <generics/array.h>
+
+// Amount of slots in the first segment, as a power of 2. Each next segment is
+// twice as large as the one before.
+#define CG_CONCURRENT_ARRAY_BASE    6
+
+_CG_BEGIN
+
+//
+// An array which many threads can append to at the same time, without any
+// locks. Each append reserves a slot with an atomic increment, so producers
+// never wait on each other. The elements are stored in segments which double
+// in size, and existing segments are never moved or copied, so a reference to
+// an element stays valid for the lifetime of the array.
+//
+// Once the producers are done, the elements can be copied or moved into a
+// regular Array with to_array() or into_array():
+//
+//  ConcurrentArray<int> results;
+//  // ... each worker thread calls results.append(value)
+//  // ... join the workers
+//  Array<int> all = results.into_array();
+//
+// The order of the elements is the order in which the slots were reserved.
+//
+template<typename T>
+class ConcurrentArray : public Printable
+{
+public:
+    static constexpr size_t base_slots = (size_t) 1 << CG_CONCURRENT_ARRAY_BASE;
+    static constexpr size_t max_segments = sizeof(size_t) * 8 - CG_CONCURRENT_ARRAY_BASE;
+
+    ConcurrentArray() : m_len(0), m_segments() {}
+
+    ConcurrentArray(ConcurrentArray const&) = delete;
+
+    // Delete all segments. No thread may be appending at this point.
+    ~ConcurrentArray()
+    {
+        clear();
+    }
+
+    // Return the amount of reserved slots. Appends which are still in progress
+    // are counted too, so this is only exact once all producers are done.
+    size_t len() const
+    {
+        return __atomic_load_n(&m_len, __ATOMIC_ACQUIRE);
+    }
+
+    // Append an element to the array, returning its index. This is safe to
+    // call from any amount of threads at once.
+    size_t append(T const& elem)
+    {
+        size_t index = __atomic_fetch_add(&m_len, 1, __ATOMIC_RELAXED);
+        _slot(index) = elem;
+        return index;
+    }
+
+    // See Array<T>::append(T&&).
+    size_t append(T&& elem)
+    {
+        size_t index = __atomic_fetch_add(&m_len, 1, __ATOMIC_RELAXED);
+        _slot(index) = (T&&) elem;
+        return index;
+    }
+
+    // Get an element at the index. The element can be read by another thread
+    // only after the append which returned its index has finished.
+    T& get(size_t index)
+    {
+        if (index >= len())
+            throw "Index is out of bounds";
+
+        return _slot(index);
+    }
+
+    // Remove all elements and free the segments. No thread may be appending
+    // at this point.
+    void clear()
+    {
+        for (size_t i = 0; i < max_segments; i++) {
+            delete[] m_segments[i];
+            m_segments[i] = nullptr;
+        }
+
+        m_len = 0;
+    }
+
+    // Call the function with each element, in order of the indices. All
+    // producers need to be done.
+    template<typename EachFunction>
+    void for_each(EachFunction&& func) const
+    {
+        size_t left = len();
+
+        for (size_t i = 0; left; i++) {
+            size_t count = _segment_size(i) < left ? _segment_size(i) : left;
+
+            for (size_t j = 0; j < count; j++)
+                func(m_segments[i][j]);
+            left -= count;
+        }
+    }
+
+    // Copy the elements into a regular Array. All producers need to be done.
+    Array<T> to_array() const
+    {
+        Array<T> result;
+
+        result.set_size(len());
+        for_each([&result] (T& elem) {
+            result.append(elem);
+        });
+
+        return result;
+    }
+
+    // Move the elements into a regular Array, leaving this one empty. All
+    // producers need to be done.
+    Array<T> into_array()
+    {
+        Array<T> result;
+
+        result.set_size(len());
+        for_each([&result] (T& elem) {
+            result.append((T&&) elem);
+        });
+
+        clear();
+        return result;
+    }
+
+    // Return the string representation of the array. All producers need to
+    // be done.
+    String as_string() const override
+    {
+        return to_array().as_string();
+    }
+
+    // Get an element at the given index.
+    T& operator[](size_t index)
+    {
+        return get(index);
+    }
+
+private:
+    size_t  m_len;
+    T*      m_segments[max_segments];
+
+    static size_t _segment_size(size_t segment)
+    {
+        return base_slots << segment;
+    }
+
+    // Find the slot for the index, allocating its segment if this is the first
+    // slot used in it. Segment k starts at index base_slots * (2^k - 1), so
+    // the segment is the position of the highest bit of index + base_slots.
+    T& _slot(size_t index)
+    {
+        size_t shifted = index + base_slots;
+        size_t segment = (sizeof(size_t) * 8 - 1 - __builtin_clzl(shifted))
+                       - CG_CONCURRENT_ARRAY_BASE;
+        size_t offset  = shifted - _segment_size(segment);
+        T*     slots;
+
+        slots = __atomic_load_n(&m_segments[segment], __ATOMIC_ACQUIRE);
+        if (!slots)
+            slots = _alloc_segment(segment);
+
+        return slots[offset];
+    }
+
+    // Allocate the segment. If multiple threads race to allocate it, only one
+    // of the allocations is kept and the others are freed.
+    T* _alloc_segment(size_t segment)
+    {
+        T* expected = nullptr;
+        T* slots    = new T[_segment_size(segment)];
+
+        if (__atomic_compare_exchange_n(&m_segments[segment], &expected, slots,
+                false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            return slots;
+
+        delete[] slots;
+        return expected;
+    }
+};
+
+_CG_END
+
+#endif /* CG_CONCURRENT_ARRAY_H */
@@ -0,0 +1,212 @@
+/*
+ * Clean Generics
+ *
+ * Copyright (C) 2021-2022 bellrise
+ *
+ * Fixed-capacity array object.
+ */
+#ifndef CG_FIXED_ARRAY_H
+#define CG_FIXED_ARRAY_H
+
+#include <generics/string.h>
+
+_CG_BEGIN
+
+//
+// A fixed array is the compile-time sibling of Array. All N slots are stored
+// inside the object itself, so it never touches the heap, and every method
+// apart from as_string() is constexpr. This means you can build lookup tables
+// at compile time and have them land in read-only data:
+//
+//  constexpr auto squares = [] {
+//      FixedArray<int, 8> table;
+//      table.produce(8, [] (size_t i) { return (int) (i * i); });
+//      return table;
+//  }();
+//
+// Appending past the capacity throws, which turns into a compile error when
+// done in a constant expression.
+//
+template<typename T, size_t N>
+class FixedArray : public Printable
+{
+public:
+    constexpr FixedArray() : m_len(0), m_array{} {}
+
+    // Create the array from a list of values, for example:
+    //
+    //  constexpr FixedArray<int, 4> primes = {2, 3, 5, 7};
+    //
+    template<typename... Args>
+    constexpr FixedArray(T const& first, Args const&... rest)
+        : m_len(1 + sizeof...(Args)), m_array{first, ((T) rest)...}
+    {
+        static_assert(1 + sizeof...(Args) <= N, "Too many values for FixedArray");
+    }
+
+    // Return the amount of slots in the array. Like Array<T>::size(), this is
+    // the capacity and not the amount of elements.
+    constexpr size_t size() const
+    {
+        return N;
+    }
+
+    // Return the amount of elements in the array.
+    constexpr size_t len() const
+    {
+        return m_len;
+    }
+
+    // Append an element to the array. The element will get copied.
+    constexpr void append(T const& elem)
+    {
+        if (m_len >= N)
+            throw "FixedArray is full";
+
+        m_array[m_len++] = elem;
+    }
+
+    // Extend the array with another.
+    template<size_t M>
+    constexpr void append(FixedArray<T, M> const& other)
+    {
+        for (size_t i = 0; i < other.len(); i++)
+            append(other.get(i));
+    }
+
+    // Get an element at the index.
+    constexpr T& get(size_t index)
+    {
+        if (index >= m_len)
+            throw "Index is out of bounds";
+
+        return m_array[index];
+    }
+
+    constexpr T const& get(size_t index) const
+    {
+        if (index >= m_len)
+            throw "Index is out of bounds";
+
+        return m_array[index];
+    }
+
+    // Remove all elements from the array. The slots are reset to T(), so
+    // the old elements do not linger.
+    constexpr void clear()
+    {
+        for (size_t i = 0; i < m_len; i++)
+            m_array[i] = T();
+
+        m_len = 0;
+    }
+
+    // Add each element to the string using the given format function.
+    template<typename FormatFunction>
+    String as_string(FormatFunction&& formatter) const
+    {
+        if (!m_len)
+            return String("[]");
+
+        String result = "[";
+
+        for (size_t i = 0; i < m_len - 1; i++)
+            result += formatter(m_array[i]) + ", ";
+        result += formatter(m_array[m_len-1]);
+
+        return result + "]";
+    }
+
+    // See Array<T>::as_string().
+    String as_string() const override
+    {
+        return as_string([] (auto const& val) {
+            return String(val);
+        });
+    }
+
+    // Apply the mapper function to each element in the array. The return value
+    // from the function will be assigned to the given slot.
+    template<typename MapFunction>
+    constexpr void map(MapFunction&& mapper)
+    {
+        for (size_t i = 0; i < m_len; i++)
+            m_array[i] = mapper(m_array[i]);
+    }
+
+    // Filter the array and return a copy of it with elements that have returned
+    // true from the filter function. The result has the same capacity.
+    template<typename FilterFunction>
+    constexpr FixedArray filter(FilterFunction&& filter) const
+    {
+        FixedArray new_array;
+
+        for (size_t i = 0; i < m_len; i++) {
+            if (filter(m_array[i]))
+                new_array.append(m_array[i]);
+        }
+
+        return new_array;
+    }
+
+    // Reduce the array into a single value of the type. See Array<T>::reduce().
+    template<typename ReduceFunction>
+    constexpr T reduce(ReduceFunction&& reducer) const
+    {
+        if (!m_len)
+            return T();
+
+        T result = m_array[0];
+        for (size_t i = 1; i < m_len; i++)
+            result = reducer(result, m_array[i]);
+
+        return result;
+    }
+
+    // Produce elements and add them to the array. See Array<T>::produce().
+    template<typename ProduceFunction>
+    constexpr void produce(size_t amount, ProduceFunction&& producer)
+    {
+        for (size_t i = 0; i < amount; i++)
+            append(producer(i));
+    }
+
+    // Sum all the objects in the array, using a simple add lamba in reduce().
+    constexpr T sum() const
+    {
+        return reduce([] (auto const& previous, auto const& val) {
+            return previous + val;
+        });
+    }
+
+    // Range-based for loop support, see Array<T>::begin().
+    constexpr T* begin() { return &m_array[0]; }
+    constexpr T* end() { return &m_array[m_len]; }
+    constexpr T const* begin() const { return &m_array[0]; }
+    constexpr T const* end() const { return &m_array[m_len]; }
+
+    // Get an element at the given index.
+    constexpr T& operator[](size_t index)
+    {
+        return get(index);
+    }
+
+    constexpr T const& operator[](size_t index) const
+    {
+        return get(index);
+    }
+
+    // Append an element.
+    constexpr void operator+=(T const& elem)
+    {
+        append(elem);
+    }
+
+private:
+    size_t  m_len;
+    T       m_array[N ? N : 1];
+};
+
+_CG_END
+
+#endif /* CG_FIXED_ARRAY_H */
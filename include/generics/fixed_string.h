@@ -0,0 +1,180 @@
+/*
+ * Clean Generics
+ *
+ * Copyright (C) 2021-2022 bellrise
+ *
+ * Fixed-capacity string object.
+ */
+#ifndef CG_FIXED_STRING_H
+#define CG_FIXED_STRING_H
+
+#include <generics/string.h>
+
+_CG_BEGIN
+
+//
+// A fixed string holds up to N characters inline, plus the null byte, so it
+// can be built at compile time and stored in read-only data. The capacity is
+// deduced from string literals:
+//
+//  constexpr FixedString name = "generics";     // FixedString<8>
+//  constexpr auto full = name + "-fixed";       // FixedString<14>
+//
+// Like String, the contents are always null-terminated so get() can be passed
+// straight to libc functions.
+//
+template<size_t N>
+class FixedString : public Printable
+{
+public:
+    typedef char char_type;
+
+    constexpr FixedString() : m_len(0), m_val{} {}
+
+    // Copy a string literal into the fixed string.
+    template<size_t M>
+    constexpr FixedString(char_type const (&str)[M]) : m_len(0), m_val{}
+    {
+        static_assert(M - 1 <= N, "String literal is too long for FixedString");
+        append(str, M - 1);
+    }
+
+    // Return the pointer to the string for libc functions.
+    constexpr char_type const* get() const
+    {
+        return m_val;
+    }
+
+    // Get a character at the given index. Returns 0 is out of bounds.
+    constexpr char_type at(size_t index) const
+    {
+        if (index >= m_len)
+            return 0;
+
+        return m_val[index];
+    }
+
+    // Return the length of the string.
+    constexpr size_t len() const
+    {
+        return m_len;
+    }
+
+    // Return the amount of characters the string can hold.
+    constexpr size_t size() const
+    {
+        return N;
+    }
+
+    // Returns true if both strings are equal.
+    template<size_t M>
+    constexpr bool equals(FixedString<M> const& other) const
+    {
+        if (m_len != other.len())
+            return false;
+
+        for (size_t i = 0; i < m_len; i++) {
+            if (m_val[i] != other.at(i))
+                return false;
+        }
+
+        return true;
+    }
+
+    // Append the other string to this string. Throws if the result does not
+    // fit, which is a compile error in a constant expression.
+    constexpr void append(char_type const* other, size_t len)
+    {
+        if (len > N - m_len)
+            throw "FixedString is full";
+
+        for (size_t i = 0; i < len; i++)
+            m_val[m_len++] = other[i];
+        m_val[m_len] = 0;
+    }
+
+    constexpr void append(char_type value)
+    {
+        append(&value, 1);
+    }
+
+    template<size_t M>
+    constexpr void append(FixedString<M> const& other)
+    {
+        append(other.get(), other.len());
+    }
+
+    template<size_t M>
+    constexpr void append(char_type const (&other)[M])
+    {
+        append(other, M - 1);
+    }
+
+    // Make a heap-allocated copy of the string.
+    String as_string() const override
+    {
+        return String(m_val);
+    }
+
+    // Iterator support, see String::begin().
+    constexpr char_type const* begin() const { return &m_val[0]; }
+    constexpr char_type const* end() const { return &m_val[m_len]; }
+
+    // Comparison operator, calls equals().
+    template<size_t M>
+    constexpr bool operator==(FixedString<M> const& other) const
+    {
+        return equals(other);
+    }
+
+    // Addition operator. The capacity of the result is the sum of both
+    // capacities, so it can never overflow.
+    template<size_t M>
+    constexpr FixedString<N + M> operator+(FixedString<M> const& other) const
+    {
+        FixedString<N + M> new_str;
+        new_str.append(m_val, m_len);
+        new_str.append(other);
+        return new_str;
+    }
+
+    template<size_t M>
+    constexpr FixedString<N + M - 1> operator+(char_type const (&other)[M]) const
+    {
+        FixedString<N + M - 1> new_str;
+        new_str.append(m_val, m_len);
+        new_str.append(other, M - 1);
+        return new_str;
+    }
+
+    // Append operators, see append().
+    template<size_t M>
+    constexpr void operator+=(FixedString<M> const& other)
+    {
+        append(other);
+    }
+
+    template<size_t M>
+    constexpr void operator+=(char_type const (&other)[M])
+    {
+        append(other, M - 1);
+    }
+
+    // Get a character at the given index. Returns 0 is out of bounds.
+    constexpr char_type operator[](size_t index) const
+    {
+        return at(index);
+    }
+
+private:
+    size_t      m_len;
+    char_type   m_val[N + 1];
+};
+
+// Deduce the capacity from the string literal, without the null byte.
+template<size_t M>
+FixedString(char const (&)[M]) -> FixedString<M - 1>;
+
+_CG_END
+
+#endif /* CG_FIXED_STRING_H */
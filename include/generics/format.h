@@ -0,0 +1,174 @@
+/*
+ * Clean Generics
+ *
+ * Copyright (C) 2021-2022 bellrise
+ *
+ * String formatting.
+ */
+#ifndef CG_FORMAT_H
+#define CG_FORMAT_H
+
+#include <generics/string.h>
+
+//
+// Format a string with the format string parsed at compile time. Each {} in the
+// format string is replaced with the next argument, and a mismatch between the
+// amount of placeholders and arguments is a compile error:
+//
+//  String msg = CG_FORMAT("user {} took {}ms", name, ms);
+//
+// The format string has to be a string literal. The lambda wraps it in a type,
+// so format_parsed() can read it in a constant expression.
+//
+#define CG_FORMAT(fmt, ...)                                                   \
+    generic::format_parsed([] {                                               \
+        struct _format_source {                                               \
+            static constexpr char const* get() { return fmt; }                \
+        };                                                                    \
+        return _format_source();                                              \
+    }(), ##__VA_ARGS__)
+
+_CG_BEGIN
+
+//
+// A single formatted argument. Numbers are written into the inline buffer,
+// strings are referenced directly and printable objects are turned into a
+// string with as_string(). Knowing the length of each argument up front lets
+// format() allocate the result exactly once.
+//
+class FormatArg
+{
+public:
+    FormatArg(String const& value);
+    FormatArg(char const* value);
+    FormatArg(Printable const& value);
+
+    // Interned strings stay in their pool, so they are referenced directly.
+    FormatArg(Symbol const& value);
+
+    // Only the pointer of a string is kept, which would dangle for temporary
+    // strings, like the ones made by implicit conversions.
+    FormatArg(String&& value) = delete;
+
+    FormatArg(char value);
+    FormatArg(bool value);
+    FormatArg(int value);
+    FormatArg(long value);
+    FormatArg(long long value);
+    FormatArg(unsigned value);
+    FormatArg(unsigned long value);
+    FormatArg(unsigned long long value);
+    FormatArg(float value);
+    FormatArg(double value);
+
+    // The arguments may point into their own buffer, so they cannot be copied.
+    FormatArg(FormatArg const&) = delete;
+
+    // Return the formatted text, which is not null-terminated.
+    char const* get() const;
+
+    // Return the length of the formatted text.
+    size_t len() const;
+
+private:
+    char const* m_ptr;
+    size_t      m_len;
+    String      m_owned;
+    char        m_buf[32];
+
+    void _format_unsigned(unsigned long long value, bool negative);
+};
+
+// Build the string out of the format segments and the arguments. Segment i is
+// written before argument i, and the last segment after all the arguments.
+String _format(char const* fmt, size_t const* offsets, size_t const* lengths,
+               FormatArg const* args, size_t amount);
+
+// Parse the format string at runtime and build the string. Throws if the
+// amount of placeholders does not match the amount of arguments.
+String _format_runtime(char const* fmt, FormatArg const* args, size_t amount);
+
+// Segments of a format string, as found by _format_parse().
+template<size_t N>
+struct FormatSegments
+{
+    size_t offsets[N + 1];
+    size_t lengths[N + 1];
+};
+
+// Count the {} placeholders in the format string.
+constexpr size_t _format_count(char const* fmt)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; fmt[i]; i++) {
+        if (fmt[i] == '{' && fmt[i + 1] == '}') {
+            count++;
+            i++;
+        }
+    }
+
+    return count;
+}
+
+// Split the format string into the text around the N placeholders.
+template<size_t N>
+constexpr FormatSegments<N> _format_parse(char const* fmt)
+{
+    FormatSegments<N> segments {};
+    size_t start = 0;
+    size_t index = 0;
+    size_t i     = 0;
+
+    for (; fmt[i]; i++) {
+        if (fmt[i] == '{' && fmt[i + 1] == '}') {
+            segments.offsets[index] = start;
+            segments.lengths[index] = i - start;
+            index++;
+            start = i + 2;
+            i++;
+        }
+    }
+
+    segments.offsets[index] = start;
+    segments.lengths[index] = i - start;
+
+    return segments;
+}
+
+// Format with a string parsed at compile time, see CG_FORMAT.
+template<typename Source, typename... Args>
+String format_parsed(Source, Args const&... args)
+{
+    constexpr size_t placeholders = _format_count(Source::get());
+    constexpr FormatSegments<placeholders> segments
+        = _format_parse<placeholders>(Source::get());
+
+    static_assert(placeholders == sizeof...(Args),
+        "Amount of {} placeholders does not match the amount of arguments");
+
+    FormatArg formatted[sizeof...(Args) + 1] = {FormatArg(args)..., FormatArg("")};
+    return _format(Source::get(), segments.offsets, segments.lengths,
+                   formatted, sizeof...(Args));
+}
+
+//
+// Format a string, replacing each {} with the next argument. Arguments can be
+// strings, numbers or any printable object. The length of the result is known
+// before anything is written, so the result is allocated only once:
+//
+//  String msg = format("user {} took {}ms", name, ms);
+//
+// The format string is parsed at runtime, see CG_FORMAT for a version which
+// checks it at compile time.
+//
+template<typename... Args>
+String format(char const* fmt, Args const&... args)
+{
+    FormatArg formatted[sizeof...(Args) + 1] = {FormatArg(args)..., FormatArg("")};
+    return _format_runtime(fmt, formatted, sizeof...(Args));
+}
+
+_CG_END
+
+#endif /* CG_FORMAT_H */
@@ -0,0 +1,601 @@
+/*
+ * Clean Generics
+ *
+ * Copyright (C) 2021-2022 bellrise
+ *
+ * Hash-based grouping & join operators.
+ */
+#ifndef CG_GROUP_H
+#define CG_GROUP_H
+
+#include <generics/string.h>
+#include <generics/array.h>
+#include <generics/hash.h>
+
+#include <malloc.h>
+
+// Inputs with more rows than this are radix-partitioned by the hash of the key
+// before grouping or joining, see _radix_bits().
+#define CG_GROUP_RADIX_ROWS     (1 << 20)
+
+// Target amount of rows in a single partition, chosen so that the hash table
+// of a partition stays in cache.
+#define CG_GROUP_PARTITION_ROWS (1 << 16)
+
+_CG_BEGIN
+
+//
+// The result of Array<T>::group_by(). The rows are stored grouped together in
+// one array, with the rows of group i between offset i and offset i + 1, so
+// each group can be walked without any extra allocations:
+//
+//  auto by_user = orders.group_by([] (Order& o) { return o.user_id; });
+//  for (size_t i = 0; i < by_user.len(); i++)
+//      print(by_user.key(i));
+//
+// Inside a group, rows keep the order they had in the source array.
+//
+template<typename K, typename T>
+class Grouped : public Printable
+{
+public:
+    Grouped() {}
+
+    Grouped(Array<K>&& keys, Array<size_t>&& offsets, Array<T>&& rows)
+        : m_keys((Array<K>&&) keys), m_offsets((Array<size_t>&&) offsets),
+          m_rows((Array<T>&&) rows)
+    { }
+
+    // Return the amount of groups.
+    size_t len() const
+    {
+        return m_keys.len();
+    }
+
+    // Get the key of the group.
+    K& key(size_t group)
+    {
+        return m_keys[group];
+    }
+
+    // Return the amount of rows in the group.
+    size_t count(size_t group) const
+    {
+        _check(group);
+        return m_offsets.begin()[group + 1] - m_offsets.begin()[group];
+    }
+
+    // Range of the rows in the group, to use in a for loop.
+    T* begin(size_t group) const
+    {
+        _check(group);
+        return m_rows.begin() + m_offsets.begin()[group];
+    }
+
+    T* end(size_t group) const
+    {
+        _check(group);
+        return m_rows.begin() + m_offsets.begin()[group + 1];
+    }
+
+    // Return a copy of the rows in the group.
+    Array<T> group(size_t group) const
+    {
+        Array<T> result;
+
+        result.set_size(count(group));
+        for (T* it = begin(group); it != end(group); it++)
+            result.append(*it);
+
+        return result;
+    }
+
+    // Return all keys, in the order of the groups.
+    Array<K> const& keys() const
+    {
+        return m_keys;
+    }
+
+    // Return all rows, grouped together.
+    Array<T> const& rows() const
+    {
+        return m_rows;
+    }
+
+    // Return the amount of rows in each group.
+    Array<size_t> counts() const
+    {
+        Array<size_t> result;
+
+        result.set_size(len());
+        for (size_t i = 0; i < len(); i++)
+            result.append(count(i));
+
+        return result;
+    }
+
+    // Reduce each group into a single value, like Array<T>::reduce().
+    template<typename ReduceFunction>
+    Array<T> aggregate(ReduceFunction&& reducer) const
+    {
+        Array<T> result;
+
+        result.set_size(len());
+        for (size_t i = 0; i < len(); i++) {
+            T* it = begin(i);
+            T  value = *it;
+
+            for (it++; it != end(i); it++)
+                value = reducer(value, *it);
+            result.append(value);
+        }
+
+        return result;
+    }
+
+    // Sum the rows of each group, see Array<T>::sum().
+    Array<T> sum() const
+    {
+        return aggregate([] (auto& previous, auto& val) {
+            return previous + val;
+        });
+    }
+
+    // Return the string representation, with each key followed by the rows
+    // of its group.
+    String as_string() const override
+    {
+        String result = "{";
+
+        for (size_t i = 0; i < len(); i++) {
+            if (i)
+                result += ", ";
+            result += String(m_keys.begin()[i]) + ": " + String(group(i));
+        }
+
+        return result + "}";
+    }
+
+private:
+    Array<K>        m_keys;
+    Array<size_t>   m_offsets;
+    Array<T>        m_rows;
+
+    void _check(size_t group) const
+    {
+        if (group >= len())
+            throw "Index is out of bounds";
+    }
+};
+
+//
+// The result of Array<T>::count_by(), with the amount of rows for each key.
+//
+template<typename K>
+class Counted : public Printable
+{
+public:
+    Counted() {}
+
+    Counted(Array<K>&& keys, Array<size_t>&& counts)
+        : m_keys((Array<K>&&) keys), m_counts((Array<size_t>&&) counts)
+    { }
+
+    // Return the amount of distinct keys.
+    size_t len() const
+    {
+        return m_keys.len();
+    }
+
+    // Get the key at the index.
+    K& key(size_t index)
+    {
+        return m_keys[index];
+    }
+
+    // Get the amount of rows with the key at the index.
+    size_t count(size_t index)
+    {
+        return m_counts[index];
+    }
+
+    Array<K> const& keys() const
+    {
+        return m_keys;
+    }
+
+    Array<size_t> const& counts() const
+    {
+        return m_counts;
+    }
+
+    String as_string() const override
+    {
+        String result = "{";
+
+        for (size_t i = 0; i < len(); i++) {
+            if (i)
+                result += ", ";
+            result += String(m_keys.begin()[i]) + ": "
+                    + String(m_counts.begin()[i]);
+        }
+
+        return result + "}";
+    }
+
+private:
+    Array<K>        m_keys;
+    Array<size_t>   m_counts;
+};
+
+//
+// The result of Array<T>::hash_join(). Each matching pair of rows is stored as
+// an index into the left array and an index into the right array, so nothing
+// is copied and the caller picks which columns to gather.
+//
+class Joined
+{
+public:
+    Joined() {}
+
+    Joined(Array<size_t>&& left, Array<size_t>&& right)
+        : m_left((Array<size_t>&&) left), m_right((Array<size_t>&&) right)
+    { }
+
+    // Return the amount of matching pairs.
+    size_t len() const
+    {
+        return m_left.len();
+    }
+
+    // Indices of the matching rows in the left & right arrays.
+    Array<size_t> const& left() const
+    {
+        return m_left;
+    }
+
+    Array<size_t> const& right() const
+    {
+        return m_right;
+    }
+
+private:
+    Array<size_t> m_left;
+    Array<size_t> m_right;
+};
+
+// Return the amount of hash bits to partition the input by. Small inputs are
+// not partitioned at all; larger ones are split so each partition has about
+// CG_GROUP_PARTITION_ROWS rows.
+inline size_t _radix_bits(size_t rows)
+{
+    size_t bits = 0;
+
+    if (rows <= CG_GROUP_RADIX_ROWS)
+        return 0;
+
+    while ((rows >> bits) > CG_GROUP_PARTITION_ROWS && bits < 12)
+        bits++;
+
+    return bits;
+}
+
+inline size_t _radix_partition(size_t hash, size_t bits)
+{
+    return bits ? hash >> (sizeof(size_t) * 8 - bits) : 0;
+}
+
+//
+// Split the rows into 2^bits partitions by the top bits of the hash of their
+// key. order[] gets the row indices sorted by partition, keeping their order
+// within a partition, keys[] & hashes[] the matching keys and hashes, and
+// bounds[] the start of each partition plus the end of the last one. The key
+// function is called exactly once for each row.
+//
+template<typename K, typename T, typename KeyFunction>
+void _radix_scatter(T* data, size_t len, KeyFunction& key_fn, size_t bits,
+                    K* keys, size_t* order, size_t* hashes, size_t* bounds)
+{
+    size_t  parts = (size_t) 1 << bits;
+    size_t* row_hashes;
+    K*      row_keys;
+
+    if (!bits) {
+        for (size_t i = 0; i < len; i++) {
+            order[i]  = i;
+            keys[i]   = key_fn(data[i]);
+            hashes[i] = hash(keys[i]);
+        }
+
+        bounds[0] = 0;
+        bounds[1] = len;
+        return;
+    }
+
+    row_hashes = (size_t *) malloc(len * sizeof(size_t));
+    row_keys   = new K[len];
+    for (size_t i = 0; i <= parts; i++)
+        bounds[i] = 0;
+
+    // Count the rows of each partition, and turn the counts into offsets.
+    for (size_t i = 0; i < len; i++) {
+        row_keys[i]   = key_fn(data[i]);
+        row_hashes[i] = hash(row_keys[i]);
+        bounds[_radix_partition(row_hashes[i], bits) + 1]++;
+    }
+
+    for (size_t i = 0; i < parts; i++)
+        bounds[i + 1] += bounds[i];
+
+    // Scatter the rows, using the start of the next partition as a cursor
+    // and fixing it up afterwards.
+    for (size_t i = 0; i < len; i++) {
+        size_t pos = bounds[_radix_partition(row_hashes[i], bits)]++;
+        order[pos]  = i;
+        keys[pos]   = (K&&) row_keys[i];
+        hashes[pos] = row_hashes[i];
+    }
+
+    for (size_t i = parts; i > 0; i--)
+        bounds[i] = bounds[i - 1];
+    bounds[0] = 0;
+
+    delete[] row_keys;
+    free(row_hashes);
+}
+
+//
+// A hash index split into independent partitions, each small enough to stay
+// in cache while it is being built or probed. The ids are global: the ids of
+// partition p follow all the ids of the partitions before it.
+//
+template<typename K>
+class PartitionedIndex
+{
+public:
+    static constexpr size_t npos = HashIndex<K>::npos;
+
+    PartitionedIndex(size_t bits) : m_bits(bits)
+    {
+        m_parts = new HashIndex<K>[(size_t) 1 << bits];
+        m_base  = new size_t[((size_t) 1 << bits) + 1]();
+    }
+
+    PartitionedIndex(PartitionedIndex const&) = delete;
+
+    ~PartitionedIndex()
+    {
+        delete[] m_parts;
+        delete[] m_base;
+    }
+
+    // Insert the keys of the rows, which have been scattered with the same
+    // amount of bits. ids[j] is set to the id of keys[j].
+    void build(K const* keys, size_t const* hashes, size_t const* bounds,
+               size_t* ids)
+    {
+        size_t parts = (size_t) 1 << m_bits;
+
+        for (size_t p = 0; p < parts; p++) {
+            HashIndex<K>& index = m_parts[p];
+
+            for (size_t j = bounds[p]; j < bounds[p + 1]; j++)
+                ids[j] = m_base[p] + index.insert(keys[j], hashes[j]);
+
+            m_base[p + 1] = m_base[p] + index.len();
+        }
+    }
+
+    // Return the global id of the key, or npos.
+    size_t find(K const& key, size_t key_hash) const
+    {
+        size_t p  = _radix_partition(key_hash, m_bits);
+        size_t id = m_parts[p].find(key, key_hash);
+
+        return id == npos ? npos : m_base[p] + id;
+    }
+
+    // Return the amount of distinct keys.
+    size_t len() const
+    {
+        return m_base[(size_t) 1 << m_bits];
+    }
+
+    // Move the keys out, in the order of their ids.
+    Array<K> keys()
+    {
+        Array<K> result;
+        size_t   parts = (size_t) 1 << m_bits;
+
+        result.set_size(len());
+        for (size_t p = 0; p < parts; p++) {
+            for (size_t i = 0; i < m_parts[p].len(); i++)
+                result.append((K&&) m_parts[p].key(i));
+        }
+
+        return result;
+    }
+
+private:
+    size_t          m_bits;
+    HashIndex<K>*   m_parts;
+    size_t*         m_base;
+};
+
+template<typename K, typename T, typename KeyFunction>
+Grouped<K, T> _group_by(T* data, size_t len, KeyFunction& key_fn)
+{
+    size_t  bits   = _radix_bits(len);
+    size_t* order  = (size_t *) malloc((len + 1) * sizeof(size_t));
+    size_t* hashes = (size_t *) malloc((len + 1) * sizeof(size_t));
+    size_t* ids    = (size_t *) malloc((len + 1) * sizeof(size_t));
+    size_t* bounds = (size_t *) malloc((((size_t) 1 << bits) + 1) * sizeof(size_t));
+    K*      keys   = new K[len];
+    size_t  groups;
+
+    PartitionedIndex<K> index(bits);
+    Array<size_t>       offsets;
+    Array<T>            rows;
+
+    _radix_scatter(data, len, key_fn, bits, keys, order, hashes, bounds);
+    index.build(keys, hashes, bounds, ids);
+    delete[] keys;
+    groups = index.len();
+
+    // Counting sort of the rows by their group. The scatter kept the rows in
+    // order inside each partition, so they stay in order inside each group.
+    size_t* cursor = (size_t *) calloc(groups + 1, sizeof(size_t));
+
+    for (size_t j = 0; j < len; j++)
+        cursor[ids[j] + 1]++;
+    for (size_t i = 0; i < groups; i++)
+        cursor[i + 1] += cursor[i];
+
+    offsets.set_size(groups + 1);
+    for (size_t i = 0; i <= groups; i++)
+        offsets.append(cursor[i]);
+
+    // Reuse the hashes buffer for the final position of each row.
+    for (size_t j = 0; j < len; j++)
+        hashes[cursor[ids[j]]++] = order[j];
+
+    rows.set_size(len);
+    for (size_t i = 0; i < len; i++)
+        rows.append(data[hashes[i]]);
+
+    free(cursor);
+    free(bounds);
+    free(ids);
+    free(hashes);
+    free(order);
+
+    return Grouped<K, T>(index.keys(), (Array<size_t>&&) offsets,
+                         (Array<T>&&) rows);
+}
+
+template<typename K, typename T, typename KeyFunction>
+Counted<K> _count_by(T* data, size_t len, KeyFunction& key_fn)
+{
+    size_t  bits   = _radix_bits(len);
+    size_t* order  = (size_t *) malloc((len + 1) * sizeof(size_t));
+    size_t* hashes = (size_t *) malloc((len + 1) * sizeof(size_t));
+    size_t* ids    = (size_t *) malloc((len + 1) * sizeof(size_t));
+    size_t* bounds = (size_t *) malloc((((size_t) 1 << bits) + 1) * sizeof(size_t));
+    K*      keys   = new K[len];
+    size_t* counts;
+
+    PartitionedIndex<K> index(bits);
+    Array<size_t>       result;
+
+    _radix_scatter(data, len, key_fn, bits, keys, order, hashes, bounds);
+    index.build(keys, hashes, bounds, ids);
+    delete[] keys;
+
+    counts = (size_t *) calloc(index.len() + 1, sizeof(size_t));
+    for (size_t j = 0; j < len; j++)
+        counts[ids[j]]++;
+
+    result.set_size(index.len());
+    for (size_t i = 0; i < index.len(); i++)
+        result.append(counts[i]);
+
+    free(counts);
+    free(bounds);
+    free(ids);
+    free(hashes);
+    free(order);
+
+    return Counted<K>(index.keys(), (Array<size_t>&&) result);
+}
+
+template<typename A, typename B, typename KeyA, typename KeyB>
+Joined _hash_join(A* left, size_t left_len, B* right,
+                  size_t right_len, KeyA& key_left, KeyB& key_right)
+{
+    typedef _key_type<B, KeyB> K;
+
+    size_t  max_len = left_len > right_len ? left_len : right_len;
+    size_t  bits    = _radix_bits(max_len);
+    size_t  parts   = (size_t) 1 << bits;
+    size_t* r_order  = (size_t *) malloc((right_len + 1) * sizeof(size_t));
+    size_t* r_hashes = (size_t *) malloc((right_len + 1) * sizeof(size_t));
+    size_t* r_ids    = (size_t *) malloc((right_len + 1) * sizeof(size_t));
+    size_t* l_order  = (size_t *) malloc((left_len + 1) * sizeof(size_t));
+    size_t* l_hashes = (size_t *) malloc((left_len + 1) * sizeof(size_t));
+    size_t* bounds   = (size_t *) malloc((parts + 1) * sizeof(size_t));
+    K*      r_keys   = new K[right_len];
+    K*      l_keys   = new K[left_len];
+    size_t* starts;
+    size_t  groups;
+    size_t  total;
+
+    PartitionedIndex<K> index(bits);
+    Array<size_t>       out_left;
+    Array<size_t>       out_right;
+
+    // Build side: give each key of the right array an id, and sort the right
+    // rows by id so all rows with the same key are next to each other.
+    _radix_scatter(right, right_len, key_right, bits, r_keys, r_order,
+                   r_hashes, bounds);
+    index.build(r_keys, r_hashes, bounds, r_ids);
+    groups = index.len();
+    delete[] r_keys;
+
+    starts = (size_t *) calloc(groups + 1, sizeof(size_t));
+    for (size_t j = 0; j < right_len; j++)
+        starts[r_ids[j] + 1]++;
+    for (size_t i = 0; i < groups; i++)
+        starts[i + 1] += starts[i];
+
+    for (size_t j = 0; j < right_len; j++)
+        r_hashes[starts[r_ids[j]]++] = r_order[j];
+    for (size_t i = groups; i > 0; i--)
+        starts[i] = starts[i - 1];
+    starts[0] = 0;
+
+    // Probe side: the left rows are scattered with the same bits, so probing
+    // a partition only touches that partition's table. The first pass finds
+    // the id of each row and the total amount of pairs, so the output is
+    // allocated only once.
+    _radix_scatter(left, left_len, key_left, bits, l_keys, l_order, l_hashes,
+                   bounds);
+
+    total = 0;
+    for (size_t j = 0; j < left_len; j++) {
+        size_t id = index.find(l_keys[j], l_hashes[j]);
+
+        l_hashes[j] = id;
+        if (id != index.npos)
+            total += starts[id + 1] - starts[id];
+    }
+
+    delete[] l_keys;
+
+    out_left.set_size(total);
+    out_right.set_size(total);
+
+    for (size_t j = 0; j < left_len; j++) {
+        size_t id = l_hashes[j];
+        if (id == index.npos)
+            continue;
+
+        for (size_t k = starts[id]; k < starts[id + 1]; k++) {
+            out_left.append(l_order[j]);
+            out_right.append(r_hashes[k]);
+        }
+    }
+
+    free(starts);
+    free(bounds);
+    free(l_hashes);
+    free(l_order);
+    free(r_ids);
+    free(r_hashes);
+    free(r_order);
+
+    return Joined((Array<size_t>&&) out_left, (Array<size_t>&&) out_right);
+}
+
+_CG_END
+
+#endif /* CG_GROUP_H */
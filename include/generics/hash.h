@@ -0,0 +1,229 @@
+/*
+ * Clean Generics
+ *
+ * Copyright (C) 2021-2022 bellrise
+ *
+ * Hashing & hash index.
+ */
+#ifndef CG_HASH_H
+#define CG_HASH_H
+
+#include <generics/string.h>
+
+#include <malloc.h>
+#include <string.h>
+
+_CG_BEGIN
+
+//
+// Hash functions for the basic types. A custom key type can be used with the
+// hash-based containers & operators by adding a hash() overload for it in the
+// generic namespace.
+//
+
+// Mix the bits of an integer, so that similar keys end up far apart. This is
+// the finalizer from MurmurHash3.
+inline size_t hash_int(unsigned long long value)
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return (size_t) value;
+}
+
+// Hash a block of memory, 8 bytes at a time.
+size_t hash_bytes(void const* data, size_t len);
+
+inline size_t hash(char value) { return hash_int((unsigned char) value); }
+inline size_t hash(bool value) { return hash_int(value); }
+inline size_t hash(int value) { return hash_int(value); }
+inline size_t hash(long value) { return hash_int(value); }
+inline size_t hash(long long value) { return hash_int(value); }
+inline size_t hash(unsigned value) { return hash_int(value); }
+inline size_t hash(unsigned long value) { return hash_int(value); }
+inline size_t hash(unsigned long long value) { return hash_int(value); }
+
+inline size_t hash(float value)
+{
+    unsigned int bits;
+
+    // Make 0.0 and -0.0 hash the same, as they compare equal.
+    if (value == 0)
+        value = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    return hash_int(bits);
+}
+
+inline size_t hash(double value)
+{
+    unsigned long long bits;
+
+    if (value == 0)
+        value = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    return hash_int(bits);
+}
+
+inline size_t hash(char const* str)
+{
+    return hash_bytes(str, strlen(str));
+}
+
+inline size_t hash(String const& str)
+{
+    return hash_bytes(str.get(), str.len());
+}
+
+//
+// The hash index gives each distinct key a dense id, counting up from 0 in the
+// order the keys were first inserted. It is the building block for the hash
+// based operators on Array, like group_by() and hash_join(). The table uses
+// open addressing with linear probing and stores the hash next to the id, so
+// most probes never have to compare the keys themselves.
+//
+template<typename K>
+class HashIndex
+{
+public:
+    // Returned by find() if the key is not in the index.
+    static constexpr size_t npos = (size_t) -1;
+
+    HashIndex() : m_slots(nullptr), m_mask(0), m_len(0), m_size(0), m_keys(nullptr) {}
+
+    HashIndex(HashIndex const&) = delete;
+
+    ~HashIndex()
+    {
+        free(m_slots);
+        delete[] m_keys;
+    }
+
+    // Return the amount of distinct keys.
+    size_t len() const
+    {
+        return m_len;
+    }
+
+    // Return the id of the key, adding it with the next free id if it is not
+    // in the index yet.
+    size_t insert(K const& key, size_t key_hash)
+    {
+        Slot* slot;
+
+        if (2 * (m_len + 1) > m_mask + 1)
+            _grow();
+
+        slot = _probe(key, key_hash);
+        if (slot->id != npos)
+            return slot->id;
+
+        if (m_len >= m_size)
+            _grow_keys();
+
+        slot->hash = key_hash;
+        slot->id   = m_len;
+        m_keys[m_len] = key;
+
+        return m_len++;
+    }
+
+    size_t insert(K const& key)
+    {
+        return insert(key, hash(key));
+    }
+
+    // Return the id of the key, or npos if it was never inserted.
+    size_t find(K const& key, size_t key_hash) const
+    {
+        if (!m_slots)
+            return npos;
+
+        return _probe(key, key_hash)->id;
+    }
+
+    size_t find(K const& key) const
+    {
+        return find(key, hash(key));
+    }
+
+    // Get the key with the id.
+    K& key(size_t id)
+    {
+        if (id >= m_len)
+            throw "Index is out of bounds";
+
+        return m_keys[id];
+    }
+
+private:
+    struct Slot
+    {
+        size_t hash;
+        size_t id;
+    };
+
+    Slot*   m_slots;
+    size_t  m_mask;
+    size_t  m_len;
+    size_t  m_size;
+    K*      m_keys;
+
+    Slot* _probe(K const& key, size_t key_hash) const
+    {
+        size_t index = key_hash & m_mask;
+
+        while (m_slots[index].id != npos) {
+            Slot* slot = &m_slots[index];
+            if (slot->hash == key_hash && m_keys[slot->id] == key)
+                return slot;
+
+            index = (index + 1) & m_mask;
+        }
+
+        return &m_slots[index];
+    }
+
+    // Double the table, keeping it at most half full.
+    void _grow()
+    {
+        Slot*  old_slots = m_slots;
+        size_t old_size  = m_slots ? m_mask + 1 : 0;
+        size_t new_size  = old_size ? old_size * 2 : 16;
+
+        m_slots = (Slot *) malloc(new_size * sizeof(Slot));
+        m_mask  = new_size - 1;
+        memset(m_slots, 0xFF, new_size * sizeof(Slot));
+
+        for (size_t i = 0; i < old_size; i++) {
+            if (old_slots[i].id == npos)
+                continue;
+
+            size_t index = old_slots[i].hash & m_mask;
+            while (m_slots[index].id != npos)
+                index = (index + 1) & m_mask;
+            m_slots[index] = old_slots[i];
+        }
+
+        free(old_slots);
+    }
+
+    // Double the key storage, moving the keys over.
+    void _grow_keys()
+    {
+        size_t new_size = m_size ? m_size * 2 : 16;
+        K*     new_keys = new K[new_size];
+
+        for (size_t i = 0; i < m_len; i++)
+            new_keys[i] = (K&&) m_keys[i];
+
+        delete[] m_keys;
+        m_keys = new_keys;
+        m_size = new_size;
+    }
+};
+
+_CG_END
+
+#endif /* CG_HASH_H */
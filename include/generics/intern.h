@@ -0,0 +1,135 @@
+/*
+ * Clean Generics
+ *
+ * Copyright (C) 2021-2022 bellrise
+ *
+ * String interning.
+ */
+#ifndef CG_INTERN_H
+#define CG_INTERN_H
+
+#include <generics/string.h>
+
+#include <pthread.h>
+
+// Size of a single block of memory the interned strings are stored in.
+#define CG_INTERN_CHUNK     65536
+
+_CG_BEGIN
+
+// An interned string, stored once in the pool together with its hash.
+struct InternEntry
+{
+    size_t  hash;
+    size_t  len;
+    char    data[1];
+};
+
+//
+// A symbol is a handle to an interned string. Interning the same characters
+// always results in the same symbol, so comparing two symbols is a single
+// pointer comparison and the hash is computed only once. A symbol is just a
+// pointer, so it is cheap to copy and store. The default symbol is the empty
+// string.
+//
+class Symbol
+{
+public:
+    Symbol() : m_entry(nullptr) {}
+
+    // Return the pointer to the null-terminated string.
+    char const* get() const { return m_entry ? m_entry->data : ""; }
+
+    // Return the length of the string.
+    size_t len() const { return m_entry ? m_entry->len : 0; }
+
+    // Return the precomputed hash of the string.
+    size_t hash() const { return m_entry ? m_entry->hash : 0; }
+
+    // Make a String copy of the symbol.
+    String string() const { return String(get()); }
+
+    bool operator==(Symbol const& other) const { return m_entry == other.m_entry; }
+    bool operator!=(Symbol const& other) const { return m_entry != other.m_entry; }
+
+private:
+    friend class InternPool;
+
+    Symbol(InternEntry const* entry) : m_entry(entry) {}
+
+    InternEntry const* m_entry;
+};
+
+//
+// The intern pool maps strings to symbols. It is safe to use from multiple
+// threads: lookups of strings which are already interned only take a read
+// lock and do not allocate, so the common case scales across threads. The
+// strings are never freed until the pool is destroyed, which keeps all the
+// symbols valid for the lifetime of the pool.
+//
+class InternPool
+{
+public:
+    InternPool();
+
+    // Free all interned strings. Any symbols from this pool become invalid.
+    ~InternPool();
+
+    InternPool(InternPool const&) = delete;
+
+    // Return the symbol for the string, adding it to the pool if needed.
+    Symbol intern(char const* str);
+    Symbol intern(char const* str, size_t len);
+    Symbol intern(String const& str);
+
+    // Return the symbol for the string, or the empty symbol if the string has
+    // not been interned. This never adds to the pool.
+    Symbol find(char const* str, size_t len) const;
+
+    // Return the amount of interned strings.
+    size_t len() const;
+
+private:
+    mutable pthread_rwlock_t m_lock;
+
+    // Open-addressing hash table of the entries, always a power of 2 in size
+    // and at most half full.
+    InternEntry**   m_table;
+    size_t          m_slots;
+    size_t          m_len;
+
+    // Chunks of memory the entries are allocated from. The first word of each
+    // chunk points to the previous one.
+    char*           m_chunk;
+    size_t          m_chunk_used;
+    size_t          m_chunk_size;
+
+    // Find the slot of the string, which is either its entry or an empty slot
+    // where it would be inserted.
+    size_t _probe(char const* str, size_t len, size_t hash) const;
+
+    // Allocate a new entry for the string.
+    InternEntry* _new_entry(char const* str, size_t len, size_t hash);
+
+    // Double the size of the table.
+    void _grow();
+};
+
+// Symbols already carry their hash, so they can be used as keys in the hash
+// based operators without hashing the string again.
+inline size_t hash(Symbol const& symbol)
+{
+    return symbol.hash();
+}
+
+// Return the global intern pool, used by the intern() functions.
+InternPool& intern_pool();
+
+// Intern the string in the global pool.
+Symbol intern(char const* str);
+Symbol intern(char const* str, size_t len);
+Symbol intern(String const& str);
+
+_CG_END
+
+#endif /* CG_INTERN_H */
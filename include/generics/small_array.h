@@ -0,0 +1,386 @@
+/*
+ * Clean Generics
+ *
+ * Copyright (C) 2021-2022 bellrise
+ *
+ * Small array object.
+ */
+#ifndef CG_SMALL_ARRAY_H
+#define CG_SMALL_ARRAY_H
+
+#include <generics/string.h>
+#include <generics/array.h>
+
+_CG_BEGIN
+
+//
+// The small array has the same interface as Array, but the first N elements
+// are stored inside the object itself. Only when more than N elements are
+// appended, the elements are moved to the heap. Most arrays in a program are
+// tiny, so picking N right means they never allocate at all:
+//
+//  SmallArray<int, 8> ids;
+//  ids.append(1);          // no allocation
+//
+template<typename T, size_t N>
+class SmallArray : public Printable
+{
+public:
+    SmallArray() : m_size(N), m_len(0), m_array(m_inline) {}
+
+    // Copy the other array. Elements are copied one by one, so the copy only
+    // goes to the heap if the other array has more than N elements.
+    SmallArray(SmallArray const& other) : SmallArray()
+    {
+        set_size(other.m_len);
+        for (size_t i = 0; i < other.m_len; i++)
+            m_array[i] = other.m_array[i];
+
+        m_len = other.m_len;
+    }
+
+    // Move the other array. Heap storage is stolen, inline elements are moved
+    // one by one.
+    SmallArray(SmallArray&& other) : SmallArray()
+    {
+        _steal((SmallArray&&) other);
+    }
+
+    // Copy the elements of an Array.
+    SmallArray(Array<T> const& other) : SmallArray()
+    {
+        set_size(other.len());
+        for (T const& elem : other)
+            append(elem);
+    }
+
+    // Take over the storage of an Array if it does not fit inline, otherwise
+    // move the elements into the inline slots.
+    SmallArray(Array<T>&& other) : SmallArray()
+    {
+        if (other.m_len > N) {
+            m_array = other.m_array;
+            m_size  = other.m_size;
+            m_len   = other.m_len;
+
+            other.m_array = nullptr;
+            other.m_size  = 0;
+            other.m_len   = 0;
+            return;
+        }
+
+        for (size_t i = 0; i < other.m_len; i++)
+            m_array[i] = (T&&) other.m_array[i];
+
+        m_len = other.m_len;
+        other.clear();
+    }
+
+    // Delete the array.
+    ~SmallArray()
+    {
+        clear();
+    }
+
+    // Return the size of the array, which is at least N.
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    // Return the amount of elements in the array.
+    size_t len() const
+    {
+        return m_len;
+    }
+
+    // Returns true if the elements are still stored inline.
+    bool is_inline() const
+    {
+        return m_array == m_inline;
+    }
+
+    // Append an element to the array. The element will get copied.
+    void append(T const& elem)
+    {
+        if (m_len >= m_size)
+            _alloc(m_size + 1);
+
+        m_array[m_len++] = elem;
+    }
+
+    // See Array<T>::append(T&&).
+    void append(T&& elem)
+    {
+        if (m_len >= m_size)
+            _alloc(m_size + 1);
+
+        m_array[m_len++] = (T&&) elem;
+    }
+
+    // Extend the array with another.
+    void append(SmallArray const& other)
+    {
+        for (size_t i = 0; i < other.m_len; i++)
+            append(other.m_array[i]);
+    }
+
+    // Get an element at the index.
+    T& get(size_t index)
+    {
+        if (index >= m_len)
+            throw "Index is out of bounds";
+
+        return m_array[index];
+    }
+
+    // Remove all elements from the array. Heap storage is freed, and the
+    // inline slots are reset so they do not hold on to any resources.
+    void clear()
+    {
+        if (is_inline()) {
+            for (size_t i = 0; i < m_len; i++)
+                m_inline[i] = T();
+        } else {
+            Array<T>::_delete_slots(m_array, m_size);
+        }
+
+        m_size  = N;
+        m_len   = 0;
+        m_array = m_inline;
+    }
+
+    // Return a copy of the array.
+    SmallArray copy() const
+    {
+        return SmallArray(*this);
+    }
+
+    // Make sure the array has room for the amount of slots, see
+    // Array<T>::set_size().
+    void set_size(size_t slots)
+    {
+        if (m_size >= slots)
+            return;
+
+        _alloc(slots);
+    }
+
+    // Copy the elements into a regular Array.
+    Array<T> to_array() const
+    {
+        Array<T> result;
+
+        result.set_size(m_len);
+        for (size_t i = 0; i < m_len; i++)
+            result.append(m_array[i]);
+
+        return result;
+    }
+
+    // Move the elements into a regular Array. If they are on the heap, the
+    // Array takes over the storage without copying anything.
+    Array<T> into_array()
+    {
+        Array<T> result;
+
+        if (is_inline()) {
+            result.set_size(m_len);
+            for (size_t i = 0; i < m_len; i++)
+                result.append((T&&) m_array[i]);
+
+            clear();
+            return result;
+        }
+
+        result.m_array = m_array;
+        result.m_size  = m_size;
+        result.m_len   = m_len;
+
+        m_array = m_inline;
+        m_size  = N;
+        m_len   = 0;
+
+        return result;
+    }
+
+    // Add each element to the string using the given format function.
+    template<typename FormatFunction>
+    String as_string(FormatFunction&& formatter) const
+    {
+        if (!m_len)
+            return String("[]");
+
+        String result = "[";
+
+        for (size_t i = 0; i < m_len - 1; i++)
+            result += formatter(m_array[i]) + ", ";
+        result += formatter(m_array[m_len-1]);
+
+        return result + "]";
+    }
+
+    // See Array<T>::as_string().
+    String as_string() const override
+    {
+        return as_string([] (auto& val) {
+            return String(val);
+        });
+    }
+
+    // Apply the mapper function to each element in the array. The return value
+    // from the function will be assigned to the given slot.
+    template<typename MapFunction>
+    void map(MapFunction&& mapper)
+    {
+        for (size_t i = 0; i < m_len; i++)
+            m_array[i] = mapper(m_array[i]);
+    }
+
+    // Filter the array and return a copy of it with elements that have returned
+    // true from the filter function.
+    template<typename FilterFunction>
+    SmallArray filter(FilterFunction&& filter) const
+    {
+        SmallArray new_array;
+
+        for (size_t i = 0; i < m_len; i++) {
+            if (filter(m_array[i]))
+                new_array.append(m_array[i]);
+        }
+
+        return new_array;
+    }
+
+    // Reduce the array into a single value of the type, see Array<T>::reduce().
+    template<typename ReduceFunction>
+    T reduce(ReduceFunction&& reducer) const
+    {
+        if (!m_len)
+            return T();
+
+        T result = m_array[0];
+        for (size_t i = 1; i < m_len; i++)
+            result = reducer(result, m_array[i]);
+
+        return result;
+    }
+
+    // Produce elements and add them to the array, see Array<T>::produce().
+    template<typename ProduceFunction>
+    void produce(size_t amount, ProduceFunction&& producer)
+    {
+        set_size(m_len + amount);
+        for (size_t i = 0; i < amount; i++)
+            append(producer(i));
+    }
+
+    // Sum all the objects in the array, using a simple add lamba in reduce().
+    T sum() const
+    {
+        return reduce([] (auto& previous, auto& val) {
+            return previous + val;
+        });
+    }
+
+    // Range-based for loop support, see Array<T>::begin().
+    T* begin() const { return &m_array[0]; }
+    T* end() const { return &m_array[m_len]; }
+
+    // Get an element at the given index.
+    T& operator[](size_t index)
+    {
+        return get(index);
+    }
+
+    // Append an element.
+    void operator+=(T const& elem)
+    {
+        append(elem);
+    }
+
+    // Extend this array with another.
+    void operator+=(SmallArray const& other)
+    {
+        append(other);
+    }
+
+    // Assign-copy operator.
+    void operator=(SmallArray const& other)
+    {
+        if (this == &other)
+            return;
+
+        SmallArray copied(other);
+        operator=((SmallArray&&) copied);
+    }
+
+    // See SmallArray(SmallArray&& other) move constructor.
+    void operator=(SmallArray&& other)
+    {
+        clear();
+        _steal((SmallArray&&) other);
+    }
+
+protected:
+
+    // Move the elements to a heap allocation with enough slots, rounding up
+    // to the closest value defined by CG_ARRAY_ALLOC_G.
+    void _alloc(size_t slots)
+    {
+        size_t alloc_size;
+        size_t old_size;
+        T*     old_array;
+
+        alloc_size = slots - (slots % CG_ARRAY_ALLOC_G);
+        alloc_size += CG_ARRAY_ALLOC_G;
+
+        // Heap storage is allocated the same way as in Array, because the
+        // buffers are passed back and forth between the two.
+        old_size  = m_size;
+        old_array = m_array;
+        m_array   = Array<T>::_new_slots(alloc_size);
+        m_size    = alloc_size;
+
+        for (size_t i = 0; i < m_len; i++)
+            m_array[i] = (T&&) old_array[i];
+
+        if (old_array == m_inline) {
+            for (size_t i = 0; i < m_len; i++)
+                m_inline[i] = T();
+        } else {
+            Array<T>::_delete_slots(old_array, old_size);
+        }
+    }
+
+    // Take the elements of the other array, leaving it empty. This array has
+    // to be empty.
+    void _steal(SmallArray&& other)
+    {
+        if (other.is_inline()) {
+            for (size_t i = 0; i < other.m_len; i++)
+                m_inline[i] = (T&&) other.m_inline[i];
+
+            m_len = other.m_len;
+            other.clear();
+            return;
+        }
+
+        m_array = other.m_array;
+        m_size  = other.m_size;
+        m_len   = other.m_len;
+
+        other.m_array = other.m_inline;
+        other.m_size  = N;
+        other.m_len   = 0;
+    }
+
+    size_t  m_size;
+    size_t  m_len;
+    T*      m_array;
+    T       m_inline[N];
+};
+
+_CG_END
+
+#endif /* CG_SMALL_ARRAY_H */
@@ -0,0 +1,939 @@
+/*
+ * Clean Generics
+ *
+ * Copyright (C) 2021-2022 bellrise
+ *
+ * Sorted map object.
+ */
+#ifndef CG_SORTED_MAP_H
+#define CG_SORTED_MAP_H
+
+#include <generics/string.h>
+#include <generics/array.h>
+
+// Target size of the key block in a single node. Keys are stored next to each
+// other, so a search inside a node only walks a few cache lines.
+#define CG_SORTED_MAP_NODE_BYTES    256
+
+_CG_BEGIN
+
+//
+// The sorted map keeps its keys in order, so it supports range scans and
+// floor/ceiling lookups on top of the usual insert, find & erase. Internally
+// it is a B+ tree: the inner nodes only hold separator keys, and all key-value
+// pairs live in the leaves, which are linked together for iteration. Because
+// each node holds many keys, the tree is shallow and every lookup touches far
+// fewer cache lines than a binary tree like std::map.
+//
+// The key type needs to provide an operator< and be default constructible.
+// as_string() formats keys & values with the String constructors; types which
+// have no String constructor are printed as "?". keys(), values() and the bulk
+// loading constructor use Array, which can only hold types with a String
+// constructor.
+//
+template<typename K, typename V>
+class SortedMap : public Printable
+{
+    struct Node;
+    struct Leaf;
+    struct Inner;
+
+public:
+    // Maximum amount of keys in a single node. This is at least 4, so very
+    // large keys still form a proper tree.
+    static constexpr size_t order = CG_SORTED_MAP_NODE_BYTES / sizeof(K) < 4
+        ? 4 : CG_SORTED_MAP_NODE_BYTES / sizeof(K);
+
+    // Dereferencing an iterator returns a reference to both the key and the
+    // value, so you can write:
+    //
+    //  for (auto item : map)
+    //      print(item.key);
+    //
+    struct Item
+    {
+        K const& key;
+        V&       value;
+    };
+
+    class iterator
+    {
+    public:
+        iterator() : m_leaf(nullptr), m_index(0) {}
+        iterator(Leaf* leaf, size_t index) : m_leaf(leaf), m_index(index) {}
+
+        K const& key() const { return m_leaf->keys[m_index]; }
+        V& value() const { return m_leaf->values[m_index]; }
+
+        Item operator*() const
+        {
+            return Item {m_leaf->keys[m_index], m_leaf->values[m_index]};
+        }
+
+        // Move to the next key. Stepping past the last key results in the
+        // end() iterator.
+        iterator& operator++()
+        {
+            if (++m_index >= m_leaf->count && m_leaf->next) {
+                m_leaf  = m_leaf->next;
+                m_index = 0;
+            }
+
+            return *this;
+        }
+
+        // Move to the previous key. This also works on the end() iterator,
+        // but the first key has nothing before it.
+        iterator& operator--()
+        {
+            if (!m_index && m_leaf->prev) {
+                m_leaf  = m_leaf->prev;
+                m_index = m_leaf->count;
+            }
+
+            m_index--;
+            return *this;
+        }
+
+        bool operator==(iterator const& other) const
+        {
+            return m_leaf == other.m_leaf && m_index == other.m_index;
+        }
+
+        bool operator!=(iterator const& other) const
+        {
+            return !operator==(other);
+        }
+
+    private:
+        Leaf*   m_leaf;
+        size_t  m_index;
+    };
+
+    SortedMap() : m_len(0), m_root(nullptr), m_first(nullptr), m_last(nullptr) {}
+
+    // Copy the map, rebuilding the tree with bulk loading.
+    SortedMap(SortedMap const& other)
+        : m_len(0), m_root(nullptr), m_first(nullptr), m_last(nullptr)
+    {
+        _copy_from(other);
+    }
+
+    // Steal the tree from a temporary map.
+    SortedMap(SortedMap&& other)
+        : m_len(other.m_len), m_root(other.m_root), m_first(other.m_first),
+          m_last(other.m_last)
+    {
+        other.m_len   = 0;
+        other.m_root  = nullptr;
+        other.m_first = nullptr;
+        other.m_last  = nullptr;
+    }
+
+    // Build a map out of sorted keys and their matching values. This is a lot
+    // faster than inserting them one by one, because the leaves are filled in
+    // order and the inner nodes are built bottom up. The keys have to be in
+    // strictly increasing order.
+    SortedMap(Array<K> const& keys, Array<V> const& values)
+        : m_len(0), m_root(nullptr), m_first(nullptr), m_last(nullptr)
+    {
+        if (keys.len() != values.len())
+            throw "Amount of keys and values differ";
+
+        _load(keys.begin(), values.begin(), keys.len());
+    }
+
+    // Delete all nodes.
+    ~SortedMap()
+    {
+        clear();
+    }
+
+    // Return the amount of keys in the map.
+    size_t len() const
+    {
+        return m_len;
+    }
+
+    // Remove all keys from the map.
+    void clear()
+    {
+        if (m_root)
+            _free_node(m_root);
+
+        m_len   = 0;
+        m_root  = nullptr;
+        m_first = nullptr;
+        m_last  = nullptr;
+    }
+
+    // Insert the key with the value. If the key already exists, the value is
+    // replaced and false is returned.
+    bool insert(K const& key, V const& value)
+    {
+        Node* split_right;
+        K     split_key;
+        bool  inserted;
+
+        if (!m_root) {
+            Leaf* leaf = new Leaf();
+            m_root  = leaf;
+            m_first = leaf;
+            m_last  = leaf;
+        }
+
+        split_right = nullptr;
+        inserted = _insert(m_root, key, value, split_key, split_right);
+
+        // The root has been split, so the tree grows by one level.
+        if (split_right) {
+            Inner* root = new Inner();
+            root->count       = 1;
+            root->keys[0]     = split_key;
+            root->children[0] = m_root;
+            root->children[1] = split_right;
+            m_root = root;
+        }
+
+        if (inserted)
+            m_len++;
+        return inserted;
+    }
+
+    // Return a pointer to the value of the key, or nullptr if it does not
+    // exist in the map.
+    V* find(K const& key) const
+    {
+        Leaf*  leaf;
+        size_t pos;
+
+        if (!m_root)
+            return nullptr;
+
+        leaf = _find_leaf(key);
+        pos  = _lower_bound(leaf, key);
+        if (pos < leaf->count && !(key < leaf->keys[pos]))
+            return &leaf->values[pos];
+
+        return nullptr;
+    }
+
+    // Return true if the key is in the map.
+    bool contains(K const& key) const
+    {
+        return find(key) != nullptr;
+    }
+
+    // Get the value of the key.
+    V& get(K const& key)
+    {
+        V* value = find(key);
+        if (!value)
+            throw "Key does not exist";
+
+        return *value;
+    }
+
+    // Remove the key from the map, returning false if it was not there.
+    bool erase(K const& key)
+    {
+        if (!m_root || !_erase(m_root, key))
+            return false;
+
+        m_len--;
+
+        // An inner root with no keys only has a single child left, which can
+        // become the new root.
+        if (!m_root->leaf && !m_root->count) {
+            Inner* old_root = (Inner*) m_root;
+            m_root = old_root->children[0];
+            delete old_root;
+        }
+
+        if (!m_len)
+            clear();
+
+        return true;
+    }
+
+    // Return the iterator to the first key, which is not less than the given
+    // key. If there is no such key, end() is returned.
+    iterator lower_bound(K const& key) const
+    {
+        Leaf* leaf;
+
+        if (!m_root)
+            return end();
+
+        leaf = _find_leaf(key);
+        return _make_iterator(leaf, _lower_bound(leaf, key));
+    }
+
+    // Return the iterator to the first key greater than the given key.
+    iterator upper_bound(K const& key) const
+    {
+        Leaf* leaf;
+
+        if (!m_root)
+            return end();
+
+        leaf = _find_leaf(key);
+        return _make_iterator(leaf, _upper_bound(leaf, key));
+    }
+
+    // Return the iterator to the smallest key not less than the given key.
+    iterator ceiling(K const& key) const
+    {
+        return lower_bound(key);
+    }
+
+    // Return the iterator to the largest key not greater than the given key,
+    // or end() if all keys are greater.
+    iterator floor(K const& key) const
+    {
+        iterator it = upper_bound(key);
+        if (it == begin())
+            return end();
+
+        return --it;
+    }
+
+    // Call the function with each key in the range [from, to), in order. The
+    // function gets the key and a reference to the value.
+    template<typename RangeFunction>
+    void range(K const& from, K const& to, RangeFunction&& func) const
+    {
+        iterator stop = end();
+
+        for (iterator it = lower_bound(from); it != stop; ++it) {
+            if (!(it.key() < to))
+                break;
+            func(it.key(), it.value());
+        }
+    }
+
+    // Return an array of all the keys, in order.
+    Array<K> keys() const
+    {
+        Array<K> result;
+
+        result.set_size(m_len);
+        for (Leaf* leaf = m_first; leaf; leaf = leaf->next) {
+            for (size_t i = 0; i < leaf->count; i++)
+                result.append(leaf->keys[i]);
+        }
+
+        return result;
+    }
+
+    // Return an array of all the values, in the order of their keys.
+    Array<V> values() const
+    {
+        Array<V> result;
+
+        result.set_size(m_len);
+        for (Leaf* leaf = m_first; leaf; leaf = leaf->next) {
+            for (size_t i = 0; i < leaf->count; i++)
+                result.append(leaf->values[i]);
+        }
+
+        return result;
+    }
+
+    // Return the string representation of the map, with each key and value
+    // formatted using String constructors, see _format_item().
+    String as_string() const override
+    {
+        String result = "{";
+        bool   first  = true;
+
+        for (Leaf* leaf = m_first; leaf; leaf = leaf->next) {
+            for (size_t i = 0; i < leaf->count; i++) {
+                if (!first)
+                    result += ", ";
+                result += _format_item(leaf->keys[i]) + ": "
+                        + _format_item(leaf->values[i]);
+                first = false;
+            }
+        }
+
+        return result + "}";
+    }
+
+    // Range-based for loop support, see Item.
+    iterator begin() const
+    {
+        if (!m_first)
+            return iterator();
+        return iterator(m_first, 0);
+    }
+
+    iterator end() const
+    {
+        if (!m_last)
+            return iterator();
+        return iterator(m_last, m_last->count);
+    }
+
+    // Get the value of the key, inserting a default value if the key does not
+    // exist yet.
+    V& operator[](K const& key)
+    {
+        V* value = find(key);
+        if (value)
+            return *value;
+
+        insert(key, V());
+        return *find(key);
+    }
+
+    // Assign-copy operator.
+    void operator=(SortedMap const& other)
+    {
+        if (this == &other)
+            return;
+
+        clear();
+        _copy_from(other);
+    }
+
+    // See SortedMap(SortedMap&& other) move constructor.
+    void operator=(SortedMap&& other)
+    {
+        clear();
+
+        m_len   = other.m_len;
+        m_root  = other.m_root;
+        m_first = other.m_first;
+        m_last  = other.m_last;
+
+        other.m_len   = 0;
+        other.m_root  = nullptr;
+        other.m_first = nullptr;
+        other.m_last  = nullptr;
+    }
+
+private:
+
+    // as_string() is virtual, so it is compiled for every map. Formatting
+    // only the types which have a String constructor lets the map hold any
+    // other type too.
+    template<typename E>
+    static String _format_item(E const& value)
+    {
+        if constexpr (_has_string<E>::value)
+            return String(value);
+        else
+            return String("?");
+    }
+
+    // Minimum amount of keys in a non-root node, below which the node is
+    // refilled from a sibling.
+    static constexpr size_t min_keys = order / 2;
+
+    struct Node
+    {
+        Node(bool is_leaf) : count(0), leaf(is_leaf), keys() {}
+
+        size_t count;
+        bool   leaf;
+        K      keys[order];
+    };
+
+    struct Leaf : Node
+    {
+        Leaf() : Node(true), values(), prev(nullptr), next(nullptr) {}
+
+        V     values[order];
+        Leaf* prev;
+        Leaf* next;
+    };
+
+    // An inner node with `count` keys has `count + 1` children. All keys in
+    // children[i] are less than keys[i], and all keys in children[i + 1] are
+    // greater or equal to keys[i].
+    struct Inner : Node
+    {
+        Inner() : Node(false), children() {}
+
+        Node* children[order + 1];
+    };
+
+    // Return the index of the first key in the node not less than the key.
+    static size_t _lower_bound(Node const* node, K const& key)
+    {
+        size_t low  = 0;
+        size_t high = node->count;
+
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            if (node->keys[mid] < key)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+
+        return low;
+    }
+
+    // Return the index of the first key in the node greater than the key.
+    static size_t _upper_bound(Node const* node, K const& key)
+    {
+        size_t low  = 0;
+        size_t high = node->count;
+
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            if (key < node->keys[mid])
+                high = mid;
+            else
+                low = mid + 1;
+        }
+
+        return low;
+    }
+
+    // Walk down the tree to the leaf which may contain the key.
+    Leaf* _find_leaf(K const& key) const
+    {
+        Node* node = m_root;
+
+        while (!node->leaf) {
+            Inner* inner = (Inner*) node;
+            node = inner->children[_upper_bound(inner, key)];
+        }
+
+        return (Leaf*) node;
+    }
+
+    // Turn a position in a leaf into an iterator, moving to the next leaf if
+    // the position is right after the last key.
+    iterator _make_iterator(Leaf* leaf, size_t index) const
+    {
+        if (index >= leaf->count && leaf->next)
+            return iterator(leaf->next, 0);
+
+        return iterator(leaf, index);
+    }
+
+    // Insert the key into the subtree. If the node has to be split, the new
+    // right node and its separator key are returned through split_key and
+    // split_right.
+    bool _insert(Node* node, K const& key, V const& value, K& split_key,
+                 Node*& split_right)
+    {
+        if (node->leaf)
+            return _insert_leaf((Leaf*) node, key, value, split_key, split_right);
+
+        Inner* inner = (Inner*) node;
+        Node*  child_right = nullptr;
+        K      child_key;
+        size_t index;
+        bool   inserted;
+
+        index    = _upper_bound(inner, key);
+        inserted = _insert(inner->children[index], key, value, child_key,
+                           child_right);
+
+        if (!child_right)
+            return inserted;
+
+        // The child got split, so the separator and new child need to go into
+        // this node. If it is full, split it first.
+        if (inner->count == order) {
+            Inner* right = new Inner();
+            size_t mid   = order / 2;
+
+            right->count = inner->count - mid - 1;
+            for (size_t i = 0; i < right->count; i++)
+                right->keys[i] = inner->keys[mid + 1 + i];
+            for (size_t i = 0; i <= right->count; i++)
+                right->children[i] = inner->children[mid + 1 + i];
+
+            split_key    = inner->keys[mid];
+            split_right  = right;
+            inner->count = mid;
+
+            if (index > mid) {
+                inner  = right;
+                index -= mid + 1;
+            }
+        }
+
+        for (size_t i = inner->count; i > index; i--) {
+            inner->keys[i] = inner->keys[i - 1];
+            inner->children[i + 1] = inner->children[i];
+        }
+
+        inner->keys[index] = child_key;
+        inner->children[index + 1] = child_right;
+        inner->count++;
+
+        return inserted;
+    }
+
+    bool _insert_leaf(Leaf* leaf, K const& key, V const& value, K& split_key,
+                      Node*& split_right)
+    {
+        size_t pos = _lower_bound(leaf, key);
+
+        if (pos < leaf->count && !(key < leaf->keys[pos])) {
+            leaf->values[pos] = value;
+            return false;
+        }
+
+        // Split a full leaf in half, linking the new leaf after this one.
+        if (leaf->count == order) {
+            Leaf*  right = new Leaf();
+            size_t mid   = order / 2;
+
+            right->count = leaf->count - mid;
+            for (size_t i = 0; i < right->count; i++) {
+                right->keys[i]   = leaf->keys[mid + i];
+                right->values[i] = leaf->values[mid + i];
+            }
+
+            leaf->count = mid;
+            right->prev = leaf;
+            right->next = leaf->next;
+            if (leaf->next)
+                leaf->next->prev = right;
+            else
+                m_last = right;
+            leaf->next  = right;
+            split_right = right;
+
+            if (pos > mid) {
+                leaf = right;
+                pos -= mid;
+            }
+        }
+
+        for (size_t i = leaf->count; i > pos; i--) {
+            leaf->keys[i]   = leaf->keys[i - 1];
+            leaf->values[i] = leaf->values[i - 1];
+        }
+
+        leaf->keys[pos]   = key;
+        leaf->values[pos] = value;
+        leaf->count++;
+
+        if (split_right)
+            split_key = split_right->keys[0];
+
+        return true;
+    }
+
+    // Erase the key from the subtree, refilling any child which has less than
+    // min_keys keys afterwards.
+    bool _erase(Node* node, K const& key)
+    {
+        if (node->leaf) {
+            Leaf*  leaf = (Leaf*) node;
+            size_t pos  = _lower_bound(leaf, key);
+
+            if (pos >= leaf->count || key < leaf->keys[pos])
+                return false;
+
+            for (size_t i = pos + 1; i < leaf->count; i++) {
+                leaf->keys[i - 1]   = leaf->keys[i];
+                leaf->values[i - 1] = leaf->values[i];
+            }
+
+            leaf->count--;
+            return true;
+        }
+
+        Inner* inner = (Inner*) node;
+        size_t index = _upper_bound(inner, key);
+
+        if (!_erase(inner->children[index], key))
+            return false;
+
+        if (inner->children[index]->count < min_keys)
+            _rebalance(inner, index);
+
+        return true;
+    }
+
+    // Refill the child at the index by borrowing a key from a sibling, or merge
+    // it with one if both siblings are at the minimum.
+    void _rebalance(Inner* parent, size_t index)
+    {
+        Node* child = parent->children[index];
+        Node* left  = index > 0 ? parent->children[index - 1] : nullptr;
+        Node* right = index < parent->count ? parent->children[index + 1] : nullptr;
+
+        if (left && left->count > min_keys) {
+            if (child->leaf)
+                _borrow_leaf_left(parent, index);
+            else
+                _borrow_inner_left(parent, index);
+            return;
+        }
+
+        if (right && right->count > min_keys) {
+            if (child->leaf)
+                _borrow_leaf_right(parent, index);
+            else
+                _borrow_inner_right(parent, index);
+            return;
+        }
+
+        // Merge the right one of the two nodes into the left one.
+        if (left)
+            index--;
+
+        if (child->leaf)
+            _merge_leaf(parent, index);
+        else
+            _merge_inner(parent, index);
+    }
+
+    void _borrow_leaf_left(Inner* parent, size_t index)
+    {
+        Leaf* child = (Leaf*) parent->children[index];
+        Leaf* left  = (Leaf*) parent->children[index - 1];
+
+        for (size_t i = child->count; i > 0; i--) {
+            child->keys[i]   = child->keys[i - 1];
+            child->values[i] = child->values[i - 1];
+        }
+
+        child->keys[0]   = left->keys[left->count - 1];
+        child->values[0] = left->values[left->count - 1];
+        child->count++;
+        left->count--;
+
+        parent->keys[index - 1] = child->keys[0];
+    }
+
+    void _borrow_leaf_right(Inner* parent, size_t index)
+    {
+        Leaf* child = (Leaf*) parent->children[index];
+        Leaf* right = (Leaf*) parent->children[index + 1];
+
+        child->keys[child->count]   = right->keys[0];
+        child->values[child->count] = right->values[0];
+        child->count++;
+
+        for (size_t i = 1; i < right->count; i++) {
+            right->keys[i - 1]   = right->keys[i];
+            right->values[i - 1] = right->values[i];
+        }
+
+        right->count--;
+        parent->keys[index] = right->keys[0];
+    }
+
+    void _borrow_inner_left(Inner* parent, size_t index)
+    {
+        Inner* child = (Inner*) parent->children[index];
+        Inner* left  = (Inner*) parent->children[index - 1];
+
+        child->children[child->count + 1] = child->children[child->count];
+        for (size_t i = child->count; i > 0; i--) {
+            child->keys[i] = child->keys[i - 1];
+            child->children[i] = child->children[i - 1];
+        }
+
+        // The separator moves down, and the last key of the left sibling
+        // becomes the new separator.
+        child->keys[0]     = parent->keys[index - 1];
+        child->children[0] = left->children[left->count];
+        child->count++;
+
+        parent->keys[index - 1] = left->keys[left->count - 1];
+        left->count--;
+    }
+
+    void _borrow_inner_right(Inner* parent, size_t index)
+    {
+        Inner* child = (Inner*) parent->children[index];
+        Inner* right = (Inner*) parent->children[index + 1];
+
+        child->keys[child->count]         = parent->keys[index];
+        child->children[child->count + 1] = right->children[0];
+        child->count++;
+
+        parent->keys[index] = right->keys[0];
+
+        for (size_t i = 1; i < right->count; i++)
+            right->keys[i - 1] = right->keys[i];
+        for (size_t i = 1; i <= right->count; i++)
+            right->children[i - 1] = right->children[i];
+        right->count--;
+    }
+
+    // Remove the separator at the index and the child to the right of it.
+    static void _remove_separator(Inner* parent, size_t index)
+    {
+        for (size_t i = index + 1; i < parent->count; i++) {
+            parent->keys[i - 1] = parent->keys[i];
+            parent->children[i] = parent->children[i + 1];
+        }
+
+        parent->count--;
+    }
+
+    void _merge_leaf(Inner* parent, size_t index)
+    {
+        Leaf* left  = (Leaf*) parent->children[index];
+        Leaf* right = (Leaf*) parent->children[index + 1];
+
+        for (size_t i = 0; i < right->count; i++) {
+            left->keys[left->count + i]   = right->keys[i];
+            left->values[left->count + i] = right->values[i];
+        }
+
+        left->count += right->count;
+        left->next = right->next;
+        if (right->next)
+            right->next->prev = left;
+        else
+            m_last = left;
+
+        _remove_separator(parent, index);
+        delete right;
+    }
+
+    void _merge_inner(Inner* parent, size_t index)
+    {
+        Inner* left  = (Inner*) parent->children[index];
+        Inner* right = (Inner*) parent->children[index + 1];
+
+        left->keys[left->count] = parent->keys[index];
+        for (size_t i = 0; i < right->count; i++)
+            left->keys[left->count + 1 + i] = right->keys[i];
+        for (size_t i = 0; i <= right->count; i++)
+            left->children[left->count + 1 + i] = right->children[i];
+
+        left->count += right->count + 1;
+
+        _remove_separator(parent, index);
+        delete right;
+    }
+
+    // Build the tree bottom up from sorted keys. Nodes on each level are
+    // filled evenly, so each of them has at least min_keys keys.
+    void _load(K const* keys, V const* values, size_t amount)
+    {
+        Node**  level;
+        K*      level_keys;
+        size_t  nodes;
+        size_t  offset;
+
+        clear();
+        if (!amount)
+            return;
+
+        for (size_t i = 1; i < amount; i++) {
+            if (!(keys[i - 1] < keys[i]))
+                throw "Keys are not sorted";
+        }
+
+        nodes      = (amount + order - 1) / order;
+        offset     = 0;
+        level      = new Node*[nodes];
+        level_keys = new K[nodes];
+
+        for (size_t i = 0; i < nodes; i++) {
+            Leaf*  leaf  = new Leaf();
+            size_t count = amount / nodes + (i < amount % nodes);
+
+            for (size_t j = 0; j < count; j++) {
+                leaf->keys[j]   = keys[offset + j];
+                leaf->values[j] = values[offset + j];
+            }
+
+            leaf->count = count;
+            leaf->prev  = m_last;
+            if (m_last)
+                m_last->next = leaf;
+            else
+                m_first = leaf;
+            m_last = leaf;
+
+            level[i]      = leaf;
+            level_keys[i] = keys[offset];
+            offset += count;
+        }
+
+        // Group the nodes of each level under inner nodes, keeping track of
+        // the smallest key of each subtree to use as the separators. Parents
+        // are written over the same buffers, because each group is read
+        // before its slot is reused.
+        while (nodes > 1) {
+            size_t groups = (nodes + order) / (order + 1);
+
+            offset = 0;
+            for (size_t i = 0; i < groups; i++) {
+                Inner* inner = new Inner();
+                size_t count = nodes / groups + (i < nodes % groups);
+
+                for (size_t j = 0; j < count; j++) {
+                    inner->children[j] = level[offset + j];
+                    if (j)
+                        inner->keys[j - 1] = level_keys[offset + j];
+                }
+
+                inner->count  = count - 1;
+                level[i]      = inner;
+                level_keys[i] = level_keys[offset];
+                offset += count;
+            }
+
+            nodes = groups;
+        }
+
+        m_root = level[0];
+        m_len  = amount;
+
+        delete[] level;
+        delete[] level_keys;
+    }
+
+    // Copy the pairs out of the leaves into plain buffers, so copying does
+    // not need Array<K> & Array<V>, see the note above the class.
+    void _copy_from(SortedMap const& other)
+    {
+        K*     keys   = new K[other.m_len];
+        V*     values = new V[other.m_len];
+        size_t amount = 0;
+
+        for (Leaf* leaf = other.m_first; leaf; leaf = leaf->next) {
+            for (size_t i = 0; i < leaf->count; i++, amount++) {
+                keys[amount]   = leaf->keys[i];
+                values[amount] = leaf->values[i];
+            }
+        }
+
+        _load(keys, values, amount);
+
+        delete[] keys;
+        delete[] values;
+    }
+
+    void _free_node(Node* node)
+    {
+        if (node->leaf) {
+            delete (Leaf*) node;
+            return;
+        }
+
+        Inner* inner = (Inner*) node;
+        for (size_t i = 0; i <= inner->count; i++)
+            _free_node(inner->children[i]);
+
+        delete inner;
+    }
+
+    size_t  m_len;
+    Node*   m_root;
+    Leaf*   m_first;
+    Leaf*   m_last;
+};
+
+_CG_END
+
+#endif /* CG_SORTED_MAP_H */
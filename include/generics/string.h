@@ -14,6 +14,70 @@
 
 _CG_BEGIN
 
+//
+// Iterator over the code points of UTF-8 text. Each step decodes one code
+// point; invalid or truncated sequences are returned as U+FFFD, consuming a
+// single byte, so iterating never fails.
+//
+class CodepointIterator
+{
+public:
+    typedef unsigned int codepoint_type;
+
+    CodepointIterator(char const* ptr, char const* end);
+
+    // Return the code point at the current position.
+    codepoint_type operator*() const { return m_codepoint; }
+
+    // Move to the next code point.
+    CodepointIterator& operator++();
+
+    bool operator!=(CodepointIterator const& other) const
+    {
+        return m_ptr != other.m_ptr;
+    }
+
+private:
+    char const*     m_ptr;
+    char const*     m_end;
+    codepoint_type  m_codepoint;
+    size_t          m_width;
+
+    // Decode the code point at m_ptr into m_codepoint & m_width.
+    void _decode();
+};
+
+// Range of code points, returned by String::codepoints().
+class Codepoints
+{
+public:
+    Codepoints(char const* ptr, size_t len) : m_ptr(ptr), m_len(len) {}
+
+    CodepointIterator begin() const
+    {
+        return CodepointIterator(m_ptr, m_ptr + m_len);
+    }
+
+    CodepointIterator end() const
+    {
+        return CodepointIterator(m_ptr + m_len, m_ptr + m_len);
+    }
+
+private:
+    char const* m_ptr;
+    size_t      m_len;
+};
+
+// Validation and counting on raw UTF-8 bytes, used by the String methods of
+// the same name. On x86 they use SIMD instructions when the CPU has them.
+bool utf8_is_ascii(char const* str, size_t len);
+bool utf8_is_valid(char const* str, size_t len);
+size_t utf8_codepoint_count(char const* str, size_t len);
+
+// The portable validator, which utf8_is_valid() falls back to when the CPU
+// has no SIMD support. The results of both always match.
+bool _utf8_is_valid_scalar(char const* str, size_t len);
+
 /*
  * The string class is a convenience wrapper around the C-style null-terminated
  * string. It ensures that the string is always end with a 0x00 byte, so it can
@@ -42,6 +106,12 @@ public:
     template<typename E>
     String(Array<E> const& value) : String(value.as_string()) {}
 
+    // Any other printable object is formatted using its as_string() method.
+    String(Printable const& value);
+
+    // Copy the characters of an interned string, see generics/intern.h.
+    String(Symbol const& value);
+
     // Free all used resources.
     ~String();
 
@@ -60,6 +130,31 @@ public:
     // Returns a new copy of the string.
     String copy() const;
 
+    // Returns true if the string only contains 7-bit ASCII characters. Such a
+    // string is always valid UTF-8, with one code point per byte, so this can
+    // be used to pick a faster path for plain text.
+    bool is_ascii() const;
+
+    // Returns true if the string is well-formed UTF-8. Overlong encodings,
+    // surrogates and code points past U+10FFFF are rejected.
+    bool is_valid_utf8() const;
+
+    // Return the amount of UTF-8 code points in the string. This counts all
+    // bytes which are not continuation bytes, so it is only exact for valid
+    // UTF-8; see is_valid_utf8().
+    size_t codepoint_count() const;
+
+    // Iterate over the UTF-8 code points of the string:
+    //
+    //  for (auto codepoint : some_string.codepoints())
+    //      // Do stuff...
+    //
+    Codepoints codepoints() const;
+
+    // Make sure the string can hold `len` characters without reallocating.
+    // Use this before appending many parts, so only one allocation happens.
+    void reserve(size_t len);
+
     // Append the other string to this string.
     void append(String const& other);
     void append(char_type const* other);
@@ -87,6 +182,10 @@ public:
     // Comparison operator, calls equals().
     bool operator==(String const& other) const;
 
+    // Ordering operator, comparing the bytes of both strings. A string which
+    // is a prefix of the other one is the smaller one.
+    bool operator<(String const& other) const;
+
     // Addition operator, returns a copy of the created string.
     String operator+(String const& other) const;
 
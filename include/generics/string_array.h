@@ -0,0 +1,148 @@
+/*
+ * Clean Generics
+ *
+ * Copyright (C) 2021-2022 bellrise
+ *
+ * Packed string array object.
+ */
+#ifndef CG_STRING_ARRAY_H
+#define CG_STRING_ARRAY_H
+
+#include <generics/string.h>
+#include <generics/array.h>
+#include <generics/bit_array.h>
+
+_CG_BEGIN
+
+//
+// A packed array of strings. Instead of a separate String allocation for each
+// element like Array<String>, all the characters are stored one after another
+// in a single buffer, and a second buffer holds the offset of each string.
+// This makes large columns of short strings much smaller, keeps them together
+// in memory, and copying the whole array is just two memcpy calls.
+//
+// Each string is still null-terminated inside the buffer, so get() can be
+// passed to libc functions. The pointers are only valid until the next append,
+// as the buffer may move.
+//
+class StringArray : public Printable
+{
+public:
+    typedef char char_type;
+
+    StringArray();
+    StringArray(StringArray const& other);
+    StringArray(StringArray&& other) noexcept;
+
+    // Free both buffers.
+    ~StringArray();
+
+    // Return the amount of strings in the array.
+    size_t len() const;
+
+    // Return the length of the string at the index.
+    size_t len(size_t index) const;
+
+    // Return the amount of characters stored, including the null bytes.
+    size_t bytes() const;
+
+    // Append a string to the array. The characters are copied into the buffer.
+    void append(char_type const* str);
+    void append(char_type const* str, size_t len);
+    void append(String const& str);
+
+    // Get a pointer to the string at the index.
+    char_type const* get(size_t index) const;
+
+    // Make a String copy of the string at the index.
+    String string(size_t index) const;
+
+    // Remove all strings from the array.
+    void clear();
+
+    // Allocate room for the amount of strings with the given total length, so
+    // appending them does not need to reallocate.
+    void set_size(size_t strings, size_t chars);
+
+    // Return the order of indices which sorts the strings, in the same order
+    // as String::operator<. Equal strings keep their original order.
+    Array<size_t> sort_order() const;
+
+    // Return a new array with the strings at the given indices, in that order.
+    // Both buffers are allocated once, as the total size is known up front.
+    StringArray permute(Array<size_t> const& order) const;
+
+    // Sort the strings in place, see sort_order().
+    void sort();
+
+    // Call the filter function with a pointer to each string and its length,
+    // and return a bit array where bit i is set if string i passed. See
+    // Array<T>::mask().
+    template<typename FilterFunction>
+    BitArray mask(FilterFunction&& filter) const
+    {
+        BitArray result;
+        size_t   i = 0;
+
+        while (i < m_len) {
+            BitArray::word_type word = 0;
+            size_t bits = m_len - i < BitArray::word_bits
+                ? m_len - i : BitArray::word_bits;
+
+            for (size_t j = 0; j < bits; j++) {
+                word |= (BitArray::word_type) !!filter(get(i + j), len(i + j))
+                    << j;
+            }
+
+            result.append_word(word, bits);
+            i += bits;
+        }
+
+        return result;
+    }
+
+    // Return a new array with the strings which have their bit set in the
+    // mask. The mask needs to be as long as the array.
+    StringArray select(BitArray const& mask) const;
+
+    // Filter the array and return a copy of it with the strings for which
+    // the filter function, called with the pointer and length, returned true.
+    template<typename FilterFunction>
+    StringArray filter(FilterFunction&& filter) const
+    {
+        return select(mask(filter));
+    }
+
+    // Return the string representation of the array.
+    String as_string() const override;
+
+    // Get a pointer to the string at the index.
+    char_type const* operator[](size_t index) const;
+
+    // Append a string.
+    void operator+=(char_type const* str);
+    void operator+=(String const& str);
+
+    void operator=(StringArray const& other);
+    void operator=(StringArray&& other);
+
+private:
+    size_t      m_len;
+    size_t      m_slots;
+    size_t      m_bytes;
+    size_t      m_size;
+
+    // Offset of each string in m_data. There is always one more offset than
+    // strings, so the length of string i is m_offsets[i + 1] - m_offsets[i],
+    // minus the null byte.
+    size_t*     m_offsets;
+    char_type*  m_data;
+
+    // Make room for `strings` offsets and `bytes` characters, doubling the
+    // capacity of each buffer as needed.
+    void _alloc(size_t strings, size_t bytes);
+};
+
+_CG_END
+
+#endif /* CG_STRING_ARRAY_H */
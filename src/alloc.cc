@@ -0,0 +1,362 @@
+/*
+ * Clean Generics
+ *
+ * Copyright (C) 2021-2022 bellrise
+ */
+#include <generics/alloc.h>
+#include <string.h>
+#include <malloc.h>
+
+#ifdef CG_ALLOCATOR
+#include <pthread.h>
+#endif
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+_CG_BEGIN
+
+#ifndef CG_ALLOCATOR
+
+void* mem_alloc(size_t bytes)
+{
+    return malloc(bytes);
+}
+
+void* mem_realloc(void* ptr, size_t bytes)
+{
+    return realloc(ptr, bytes);
+}
+
+void mem_free(void* ptr)
+{
+    free(ptr);
+}
+
+#else
+
+// Classes 0-15 are every multiple of 16 up to 256 bytes, the ones after that
+// are powers of 2 up to CG_ALLOC_MAX_SMALL. Large blocks use the class after
+// the last one.
+#define _SMALL_CLASSES      16
+#define _CLASSES            (_SMALL_CLASSES + 7)
+#define _LARGE              _CLASSES
+
+struct ThreadCache;
+
+// Every block starts with a header, which keeps the payload aligned to
+// CG_ALLOC_ALIGN bytes.
+struct alignas(CG_ALLOC_ALIGN) BlockHeader
+{
+    ThreadCache*    owner;
+    size_t          size_class;
+};
+
+// A free block links to the next one in the space of the payload.
+struct FreeBlock
+{
+    BlockHeader     header;
+    FreeBlock*      next;
+};
+
+struct ThreadCache
+{
+    FreeBlock*      free[_CLASSES];
+
+    // Blocks freed by other threads. Any thread may push onto this list, but
+    // only the owner takes them off, all at once, so there is no ABA problem.
+    FreeBlock*      remote;
+
+    // The current chunk blocks are carved from. The first 16 bytes of each
+    // chunk point to the previous one.
+    char*           chunk;
+    size_t          chunk_used;
+
+    // Link in the list of caches left behind by exited threads.
+    ThreadCache*    next_orphan;
+};
+
+static thread_local ThreadCache* t_cache = nullptr;
+
+static pthread_once_t  s_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t   s_key;
+static pthread_mutex_t s_orphan_lock = PTHREAD_MUTEX_INITIALIZER;
+static ThreadCache*    s_orphans = nullptr;
+
+static size_t _size_class(size_t bytes)
+{
+    size_t size_class = _SMALL_CLASSES;
+    size_t class_size = 512;
+
+    if (bytes <= 256)
+        return bytes ? (bytes - 1) / 16 : 0;
+
+    while (class_size < bytes) {
+        class_size <<= 1;
+        size_class++;
+    }
+
+    return size_class;
+}
+
+static size_t _class_size(size_t size_class)
+{
+    if (size_class < _SMALL_CLASSES)
+        return (size_class + 1) * 16;
+
+    return (size_t) 512 << (size_class - _SMALL_CLASSES);
+}
+
+// Give the cache back when the thread exits. The blocks it owns may still be
+// in use by other threads, so the cache is never freed, but kept for the next
+// thread which needs one.
+static void _orphan_cache(void* data)
+{
+    ThreadCache* cache = (ThreadCache *) data;
+
+    t_cache = nullptr;
+
+    pthread_mutex_lock(&s_orphan_lock);
+    cache->next_orphan = s_orphans;
+    s_orphans = cache;
+    pthread_mutex_unlock(&s_orphan_lock);
+}
+
+static void _create_key()
+{
+    pthread_key_create(&s_key, _orphan_cache);
+}
+
+static ThreadCache* _thread_cache()
+{
+    ThreadCache* cache;
+
+    if (t_cache)
+        return t_cache;
+
+    pthread_once(&s_key_once, _create_key);
+
+    pthread_mutex_lock(&s_orphan_lock);
+    cache = s_orphans;
+    if (cache)
+        s_orphans = cache->next_orphan;
+    pthread_mutex_unlock(&s_orphan_lock);
+
+    if (!cache)
+        cache = (ThreadCache *) calloc(1, sizeof(ThreadCache));
+
+    cache->next_orphan = nullptr;
+    pthread_setspecific(s_key, cache);
+    t_cache = cache;
+
+    return cache;
+}
+
+// Move the blocks freed by other threads to the local free lists.
+static void _take_remote(ThreadCache* cache)
+{
+    FreeBlock* block;
+
+    if (!__atomic_load_n(&cache->remote, __ATOMIC_RELAXED))
+        return;
+
+    block = __atomic_exchange_n(&cache->remote, nullptr, __ATOMIC_ACQUIRE);
+    while (block) {
+        FreeBlock* next = block->next;
+        size_t     size_class = block->header.size_class;
+
+        block->next = cache->free[size_class];
+        cache->free[size_class] = block;
+        block = next;
+    }
+}
+
+// Carve a new block from the current chunk, starting a new chunk if the block
+// does not fit. The rest of the old chunk is left unused.
+static BlockHeader* _carve(ThreadCache* cache, size_t size_class)
+{
+    size_t       size = _class_size(size_class);
+    BlockHeader* block;
+
+    if (!cache->chunk || cache->chunk_used + size > CG_ALLOC_CHUNK) {
+        char* chunk = (char *) malloc(CG_ALLOC_CHUNK);
+        if (!chunk)
+            return nullptr;
+
+        memcpy(chunk, &cache->chunk, sizeof(char*));
+        cache->chunk      = chunk;
+        cache->chunk_used = sizeof(BlockHeader);
+    }
+
+    block = (BlockHeader *) (cache->chunk + cache->chunk_used);
+    cache->chunk_used += size;
+
+    block->owner      = cache;
+    block->size_class = size_class;
+
+    return block;
+}
+
+void* mem_alloc(size_t bytes)
+{
+    size_t       total;
+    size_t       size_class;
+    ThreadCache* cache;
+    BlockHeader* block;
+
+    // Every block needs some payload, because a free block keeps its link to
+    // the next one there. Empty strings still write their null byte too.
+    if (!bytes)
+        bytes = 1;
+
+    total = bytes + sizeof(BlockHeader);
+    if (total > CG_ALLOC_MAX_SMALL) {
+        block = (BlockHeader *) malloc(total);
+        if (!block)
+            return nullptr;
+
+        block->owner      = nullptr;
+        block->size_class = _LARGE;
+        return block + 1;
+    }
+
+    size_class = _size_class(total);
+    cache      = _thread_cache();
+
+    if (!cache->free[size_class])
+        _take_remote(cache);
+
+    if (cache->free[size_class]) {
+        FreeBlock* free_block = cache->free[size_class];
+        cache->free[size_class] = free_block->next;
+        return &free_block->header + 1;
+    }
+
+    block = _carve(cache, size_class);
+    return block ? block + 1 : nullptr;
+}
+
+void* mem_realloc(void* ptr, size_t bytes)
+{
+    BlockHeader* block;
+    size_t       old_bytes;
+    void*        new_ptr;
+
+    if (!ptr)
+        return mem_alloc(bytes);
+
+    if (!bytes)
+        bytes = 1;
+
+    block = (BlockHeader *) ptr - 1;
+
+    if (block->size_class == _LARGE) {
+        if (bytes + sizeof(BlockHeader) > CG_ALLOC_MAX_SMALL) {
+            block = (BlockHeader *) realloc(block, bytes + sizeof(BlockHeader));
+            return block ? block + 1 : nullptr;
+        }
+
+        // Shrinking into a size class, which only needs the new size copied.
+        old_bytes = bytes;
+    } else {
+        // The block already has room, so there is nothing to do.
+        if (_size_class(bytes + sizeof(BlockHeader)) == block->size_class)
+            return ptr;
+
+        old_bytes = _class_size(block->size_class) - sizeof(BlockHeader);
+    }
+
+    new_ptr = mem_alloc(bytes);
+    if (!new_ptr)
+        return nullptr;
+
+    memcpy(new_ptr, ptr, old_bytes < bytes ? old_bytes : bytes);
+    mem_free(ptr);
+
+    return new_ptr;
+}
+
+void mem_free(void* ptr)
+{
+    BlockHeader* block;
+    FreeBlock*   free_block;
+    ThreadCache* owner;
+
+    if (!ptr)
+        return;
+
+    block = (BlockHeader *) ptr - 1;
+    if (block->size_class == _LARGE) {
+        free(block);
+        return;
+    }
+
+    free_block = (FreeBlock *) block;
+    owner      = block->owner;
+
+    if (owner == t_cache) {
+        free_block->next = owner->free[block->size_class];
+        owner->free[block->size_class] = free_block;
+        return;
+    }
+
+    // The block belongs to another thread, hand it back to its owner.
+    free_block->next = __atomic_load_n(&owner->remote, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&owner->remote, &free_block->next,
+                free_block, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+}
+
+#endif /* CG_ALLOCATOR */
+
+#ifdef __linux__
+
+void* map_alloc(size_t bytes)
+{
+    char*  map;
+    char*  aligned;
+    size_t head;
+
+    // Map an extra granule, so the start can be aligned for huge pages. The
+    // unused parts at both ends are unmapped again.
+    map = (char *) mmap(nullptr, bytes + CG_MAP_GRANULE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED)
+        return nullptr;
+
+    aligned = (char *) (((size_t) map + CG_MAP_GRANULE - 1) & ~(CG_MAP_GRANULE - 1));
+    head    = aligned - map;
+
+    if (head)
+        munmap(map, head);
+    munmap(aligned + bytes, CG_MAP_GRANULE - head);
+
+#ifdef MADV_HUGEPAGE
+    madvise(aligned, bytes, MADV_HUGEPAGE);
+#endif
+
+    return aligned;
+}
+
+void* map_realloc(void* ptr, size_t old_bytes, size_t bytes)
+{
+    void* map;
+
+    // The kernel grows the mapping in place if it can, otherwise it moves the
+    // page tables to a new address. The huge page advice stays with the pages.
+    map = mremap(ptr, old_bytes, bytes, MREMAP_MAYMOVE);
+    if (map == MAP_FAILED)
+        return nullptr;
+
+    return map;
+}
+
+void map_free(void* ptr, size_t bytes)
+{
+    munmap(ptr, bytes);
+}
+
+#endif /* __linux__ */
+
+_CG_END
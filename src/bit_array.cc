@@ -0,0 +1,395 @@
+/*
+ * Clean Generics
+ *
+ * Copyright (C) 2021-2022 bellrise
+ */
+#include <generics/bit_array.h>
+#include <string.h>
+#include <malloc.h>
+
+#if defined(__x86_64__)
+# define CG_BIT_ARRAY_X86
+# include <immintrin.h>
+#endif
+
+_CG_BEGIN
+
+typedef BitArray::word_type word_type;
+
+static size_t _words_for(size_t bits)
+{
+    return (bits + BitArray::word_bits - 1) / BitArray::word_bits;
+}
+
+static size_t _count_scalar(word_type const* words, size_t amount)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < amount; i++)
+        count += __builtin_popcountll(words[i]);
+
+    return count;
+}
+
+#ifdef CG_BIT_ARRAY_X86
+
+// Same loop, but compiled with the popcnt instruction instead of the generic
+// bit-twiddling fallback.
+__attribute__((target("popcnt")))
+static size_t _count_popcnt(word_type const* words, size_t amount)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < amount; i++)
+        count += __builtin_popcountll(words[i]);
+
+    return count;
+}
+
+// Count 256 bits at once by looking up the popcount of each nibble with a
+// shuffle, and summing the bytes with sad (Mula's algorithm).
+__attribute__((target("avx2")))
+static size_t _count_avx2(word_type const* words, size_t amount)
+{
+    __m256i const lookup = _mm256_setr_epi8(
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    __m256i const low_mask = _mm256_set1_epi8(0x0F);
+    __m256i total = _mm256_setzero_si256();
+    size_t  count;
+    size_t  i;
+
+    for (i = 0; i + 4 <= amount; i += 4) {
+        __m256i value = _mm256_loadu_si256((__m256i const*) (words + i));
+        __m256i low   = _mm256_and_si256(value, low_mask);
+        __m256i high  = _mm256_and_si256(_mm256_srli_epi16(value, 4), low_mask);
+        __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low),
+                                        _mm256_shuffle_epi8(lookup, high));
+
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+    }
+
+    count = _mm256_extract_epi64(total, 0) + _mm256_extract_epi64(total, 1)
+          + _mm256_extract_epi64(total, 2) + _mm256_extract_epi64(total, 3);
+
+    return count + _count_popcnt(words + i, amount - i);
+}
+
+#endif
+
+BitArray::BitArray() : m_len(0), m_words(0), m_size(0), m_bits(nullptr) {}
+
+BitArray::BitArray(size_t len, bool value)
+    : m_len(0), m_words(0), m_size(0), m_bits(nullptr)
+{
+    if (!len)
+        return;
+
+    _alloc(_words_for(len));
+    m_len   = len;
+    m_words = _words_for(len);
+    fill(value);
+}
+
+BitArray::BitArray(BitArray const& other)
+    : m_len(0), m_words(0), m_size(0), m_bits(nullptr)
+{
+    if (!other.m_len)
+        return;
+
+    _alloc(other.m_words);
+    memcpy(m_bits, other.m_bits, other.m_words * sizeof(word_type));
+
+    m_len   = other.m_len;
+    m_words = other.m_words;
+}
+
+BitArray::BitArray(BitArray&& other) noexcept
+    : m_len(other.m_len), m_words(other.m_words), m_size(other.m_size),
+      m_bits(other.m_bits)
+{
+    other.m_len   = 0;
+    other.m_words = 0;
+    other.m_size  = 0;
+    other.m_bits  = nullptr;
+}
+
+BitArray::~BitArray()
+{
+    clear();
+}
+
+size_t BitArray::len() const
+{
+    return m_len;
+}
+
+void BitArray::append(bool value)
+{
+    if (m_len % word_bits == 0) {
+        if (m_words >= m_size)
+            _alloc(m_words + 1);
+        m_bits[m_words++] = 0;
+    }
+
+    m_bits[m_len / word_bits] |= (word_type) value << (m_len % word_bits);
+    m_len++;
+}
+
+void BitArray::append_word(word_type word, size_t bits)
+{
+    size_t shift;
+
+    if (!bits)
+        return;
+
+    if (bits < word_bits)
+        word &= ((word_type) 1 << bits) - 1;
+
+    shift = m_len % word_bits;
+    if (shift)
+        m_bits[m_words - 1] |= word << shift;
+
+    // The part of the word which did not fit goes into the next word.
+    if (m_len + bits > m_words * word_bits) {
+        if (m_words >= m_size)
+            _alloc(m_words + 1);
+        m_bits[m_words++] = shift ? word >> (word_bits - shift) : word;
+    }
+
+    m_len += bits;
+}
+
+bool BitArray::get(size_t index) const
+{
+    if (index >= m_len)
+        throw "Index is out of bounds";
+
+    return (m_bits[index / word_bits] >> (index % word_bits)) & 1;
+}
+
+void BitArray::set(size_t index, bool value)
+{
+    word_type bit;
+
+    if (index >= m_len)
+        throw "Index is out of bounds";
+
+    bit = (word_type) 1 << (index % word_bits);
+    if (value)
+        m_bits[index / word_bits] |= bit;
+    else
+        m_bits[index / word_bits] &= ~bit;
+}
+
+void BitArray::fill(bool value)
+{
+    if (!m_words)
+        return;
+
+    memset(m_bits, value ? 0xFF : 0, m_words * sizeof(word_type));
+    _mask_tail();
+}
+
+void BitArray::clear()
+{
+    free(m_bits);
+
+    m_len   = 0;
+    m_words = 0;
+    m_size  = 0;
+    m_bits  = nullptr;
+}
+
+size_t BitArray::count() const
+{
+#ifdef CG_BIT_ARRAY_X86
+    static bool const has_avx2   = __builtin_cpu_supports("avx2");
+    static bool const has_popcnt = __builtin_cpu_supports("popcnt");
+
+    if (has_avx2)
+        return _count_avx2(m_bits, m_words);
+    if (has_popcnt)
+        return _count_popcnt(m_bits, m_words);
+#endif
+
+    return _count_scalar(m_bits, m_words);
+}
+
+bool BitArray::any() const
+{
+    for (size_t i = 0; i < m_words; i++) {
+        if (m_bits[i])
+            return true;
+    }
+
+    return false;
+}
+
+size_t BitArray::find_next(size_t index) const
+{
+    size_t    word_index;
+    word_type word;
+
+    if (index >= m_len)
+        return m_len;
+
+    // Mask off the bits before the index in the first word.
+    word_index = index / word_bits;
+    word = m_bits[word_index] & (~(word_type) 0 << (index % word_bits));
+
+    while (!word) {
+        if (++word_index >= m_words)
+            return m_len;
+        word = m_bits[word_index];
+    }
+
+    return word_index * word_bits + __builtin_ctzll(word);
+}
+
+size_t BitArray::find_first() const
+{
+    return find_next(0);
+}
+
+void BitArray::invert()
+{
+    for (size_t i = 0; i < m_words; i++)
+        m_bits[i] = ~m_bits[i];
+
+    _mask_tail();
+}
+
+BitArray::word_type const* BitArray::words() const
+{
+    return m_bits;
+}
+
+size_t BitArray::word_count() const
+{
+    return m_words;
+}
+
+String BitArray::as_string() const
+{
+    String result;
+
+    if (!m_len)
+        return String("[]");
+
+    // Each bit takes 3 characters, apart from the last one.
+    result.reserve(m_len * 3);
+    result.append("[");
+
+    for (size_t i = 0; i < m_len; i++) {
+        if (i)
+            result.append(", ", 2);
+        result.append(get(i) ? "1" : "0", 1);
+    }
+
+    result.append("]", 1);
+    return result;
+}
+
+bool BitArray::operator[](size_t index) const
+{
+    return get(index);
+}
+
+BitArray BitArray::operator&(BitArray const& other) const
+{
+    BitArray result(*this);
+    result &= other;
+    return result;
+}
+
+BitArray BitArray::operator|(BitArray const& other) const
+{
+    BitArray result(*this);
+    result |= other;
+    return result;
+}
+
+BitArray BitArray::operator^(BitArray const& other) const
+{
+    BitArray result(*this);
+    result ^= other;
+    return result;
+}
+
+BitArray BitArray::operator~() const
+{
+    BitArray result(*this);
+    result.invert();
+    return result;
+}
+
+void BitArray::operator&=(BitArray const& other)
+{
+    _check_len(other);
+    for (size_t i = 0; i < m_words; i++)
+        m_bits[i] &= other.m_bits[i];
+}
+
+void BitArray::operator|=(BitArray const& other)
+{
+    _check_len(other);
+    for (size_t i = 0; i < m_words; i++)
+        m_bits[i] |= other.m_bits[i];
+}
+
+void BitArray::operator^=(BitArray const& other)
+{
+    _check_len(other);
+    for (size_t i = 0; i < m_words; i++)
+        m_bits[i] ^= other.m_bits[i];
+}
+
+void BitArray::operator=(BitArray const& other)
+{
+    if (this == &other)
+        return;
+
+    BitArray copied(other);
+    operator=((BitArray&&) copied);
+}
+
+void BitArray::operator=(BitArray&& other)
+{
+    clear();
+
+    m_len   = other.m_len;
+    m_words = other.m_words;
+    m_size  = other.m_size;
+    m_bits  = other.m_bits;
+
+    other.m_len   = 0;
+    other.m_words = 0;
+    other.m_size  = 0;
+    other.m_bits  = nullptr;
+}
+
+void BitArray::_alloc(size_t words)
+{
+    size_t alloc_size = m_size ? m_size : 1;
+
+    while (alloc_size < words)
+        alloc_size *= 2;
+
+    m_size = alloc_size;
+    m_bits = (word_type *) realloc(m_bits, m_size * sizeof(word_type));
+}
+
+void BitArray::_mask_tail()
+{
+    if (m_len % word_bits)
+        m_bits[m_words - 1] &= ((word_type) 1 << (m_len % word_bits)) - 1;
+}
+
+void BitArray::_check_len(BitArray const& other) const
+{
+    if (m_len != other.m_len)
+        throw "Bit arrays differ in length";
+}
+
+_CG_END
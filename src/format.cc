@@ -0,0 +1,180 @@
+/*
+ * Clean Generics
+ *
+ * Copyright (C) 2021-2022 bellrise
+ */
+#include <generics/format.h>
+#include <generics/intern.h>
+#include <string.h>
+#include <stdio.h>
+#include <alloca.h>
+
+_CG_BEGIN
+
+FormatArg::FormatArg(String const& value)
+    : m_ptr(value.get()), m_len(value.len())
+{ }
+
+FormatArg::FormatArg(char const* value)
+    : m_ptr(value ? value : ""), m_len(value ? strlen(value) : 0)
+{ }
+
+FormatArg::FormatArg(Symbol const& value)
+    : m_ptr(value.get()), m_len(value.len())
+{ }
+
+FormatArg::FormatArg(Printable const& value) : m_owned(value.as_string())
+{
+    m_ptr = m_owned.get();
+    m_len = m_owned.len();
+}
+
+FormatArg::FormatArg(char value) : m_ptr(m_buf), m_len(1)
+{
+    m_buf[0] = value;
+}
+
+FormatArg::FormatArg(bool value)
+    : m_ptr(value ? "true" : "false"), m_len(value ? 4 : 5)
+{ }
+
+FormatArg::FormatArg(int value)
+{
+    _format_unsigned(value < 0 ? -(unsigned long long) value : value, value < 0);
+}
+
+FormatArg::FormatArg(long value)
+{
+    _format_unsigned(value < 0 ? -(unsigned long long) value : value, value < 0);
+}
+
+FormatArg::FormatArg(long long value)
+{
+    _format_unsigned(value < 0 ? -(unsigned long long) value : value, value < 0);
+}
+
+FormatArg::FormatArg(unsigned value)
+{
+    _format_unsigned(value, false);
+}
+
+FormatArg::FormatArg(unsigned long value)
+{
+    _format_unsigned(value, false);
+}
+
+FormatArg::FormatArg(unsigned long long value)
+{
+    _format_unsigned(value, false);
+}
+
+FormatArg::FormatArg(float value) : FormatArg((double) value) {}
+
+FormatArg::FormatArg(double value) : m_ptr(m_buf)
+{
+    // Same format as the String(float) constructor. Large values do not fit
+    // in the buffer, so they are formatted again into a string of the right
+    // length.
+    int written = snprintf(m_buf, sizeof(m_buf), "%f", value);
+
+    m_len = written;
+    if (written < (int) sizeof(m_buf))
+        return;
+
+    char* full = (char *) alloca(written + 1);
+    snprintf(full, written + 1, "%f", value);
+
+    m_owned = String(full);
+    m_ptr   = m_owned.get();
+}
+
+char const* FormatArg::get() const
+{
+    return m_ptr;
+}
+
+size_t FormatArg::len() const
+{
+    return m_len;
+}
+
+void FormatArg::_format_unsigned(unsigned long long value, bool negative)
+{
+    // Write the digits from the end of the buffer, so they do not have to be
+    // reversed afterwards.
+    char* end = m_buf + sizeof(m_buf);
+    char* ptr = end;
+
+    do {
+        *--ptr = '0' + (value % 10);
+        value /= 10;
+    } while (value);
+
+    if (negative)
+        *--ptr = '-';
+
+    m_ptr = ptr;
+    m_len = end - ptr;
+}
+
+String _format(char const* fmt, size_t const* offsets, size_t const* lengths,
+               FormatArg const* args, size_t amount)
+{
+    String result;
+    size_t total;
+
+    // Sum up the lengths first, so the string is allocated only once.
+    total = lengths[amount];
+    for (size_t i = 0; i < amount; i++)
+        total += lengths[i] + args[i].len();
+
+    result.reserve(total);
+
+    for (size_t i = 0; i < amount; i++) {
+        result.append(fmt + offsets[i], lengths[i]);
+        result.append(args[i].get(), args[i].len());
+    }
+
+    result.append(fmt + offsets[amount], lengths[amount]);
+    return result;
+}
+
+String _format_runtime(char const* fmt, FormatArg const* args, size_t amount)
+{
+    size_t* offsets;
+    size_t* lengths;
+    size_t  start;
+    size_t  index;
+    size_t  i;
+
+    // The segments only need to live on the stack for the duration of the
+    // call, as there are as many of them as there are arguments.
+    offsets = (size_t *) alloca(sizeof(size_t) * (amount + 1));
+    lengths = (size_t *) alloca(sizeof(size_t) * (amount + 1));
+    start = 0;
+    index = 0;
+
+    for (i = 0; fmt[i]; i++) {
+        if (fmt[i] != '{' || fmt[i + 1] != '}')
+            continue;
+
+        if (index == amount)
+            throw "Too few arguments for the format string";
+
+        offsets[index] = start;
+        lengths[index] = i - start;
+        index++;
+        start = i + 2;
+        i++;
+    }
+
+    if (index != amount)
+        throw "Too many arguments for the format string";
+
+    offsets[index] = start;
+    lengths[index] = i - start;
+
+    return _format(fmt, offsets, lengths, args, amount);
+}
+
+_CG_END
@@ -0,0 +1,34 @@
+/*
+ * Clean Generics
+ *
+ * Copyright (C) 2021-2022 bellrise
+ */
+#include <generics/hash.h>
+#include <string.h>
+
+_CG_BEGIN
+
+size_t hash_bytes(void const* data, size_t len)
+{
+    unsigned char const* bytes = (unsigned char const*) data;
+    unsigned long long   state = len * 0x9e3779b97f4a7c15ULL;
+    unsigned long long   word;
+
+    // Fold in 8 bytes at a time, rotating so the order of the words matters.
+    for (; len >= 8; len -= 8, bytes += 8) {
+        memcpy(&word, bytes, 8);
+        state = ((state << 29) | (state >> 35)) ^ word;
+        state *= 0x9e3779b97f4a7c15ULL;
+    }
+
+    if (len) {
+        word = 0;
+        memcpy(&word, bytes, len);
+        state = ((state << 29) | (state >> 35)) ^ word;
+        state *= 0x9e3779b97f4a7c15ULL;
+    }
+
+    return hash_int(state);
+}
+
+_CG_END
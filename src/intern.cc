@@ -0,0 +1,210 @@
+/*
+ * Clean Generics
+ *
+ * Copyright (C) 2021-2022 bellrise
+ */
+#include <generics/intern.h>
+#include <generics/hash.h>
+#include <string.h>
+#include <malloc.h>
+
+_CG_BEGIN
+
+InternPool::InternPool()
+    : m_table(nullptr), m_slots(0), m_len(0), m_chunk(nullptr),
+      m_chunk_used(0), m_chunk_size(0)
+{
+    pthread_rwlock_init(&m_lock, nullptr);
+}
+
+InternPool::~InternPool()
+{
+    while (m_chunk) {
+        char* previous;
+        memcpy(&previous, m_chunk, sizeof(char*));
+        free(m_chunk);
+        m_chunk = previous;
+    }
+
+    free(m_table);
+    pthread_rwlock_destroy(&m_lock);
+}
+
+Symbol InternPool::intern(char const* str)
+{
+    return intern(str, str ? strlen(str) : 0);
+}
+
+Symbol InternPool::intern(char const* str, size_t len)
+{
+    InternEntry* entry;
+    size_t       hash;
+    size_t       slot;
+
+    if (!len)
+        return Symbol();
+
+    // Most strings are already interned, which only needs the read lock.
+    hash = hash_bytes(str, len);
+    pthread_rwlock_rdlock(&m_lock);
+    if (m_slots) {
+        entry = m_table[_probe(str, len, hash)];
+        if (entry) {
+            pthread_rwlock_unlock(&m_lock);
+            return Symbol(entry);
+        }
+    }
+    pthread_rwlock_unlock(&m_lock);
+
+    // Another thread may have added the string between the two locks, so the
+    // table has to be probed again.
+    pthread_rwlock_wrlock(&m_lock);
+
+    if (m_len + 1 > m_slots / 2)
+        _grow();
+
+    slot = _probe(str, len, hash);
+    if (!m_table[slot]) {
+        m_table[slot] = _new_entry(str, len, hash);
+        m_len++;
+    }
+
+    entry = m_table[slot];
+    pthread_rwlock_unlock(&m_lock);
+
+    return Symbol(entry);
+}
+
+Symbol InternPool::intern(String const& str)
+{
+    return intern(str.get(), str.len());
+}
+
+Symbol InternPool::find(char const* str, size_t len) const
+{
+    InternEntry* entry = nullptr;
+
+    if (!len)
+        return Symbol();
+
+    pthread_rwlock_rdlock(&m_lock);
+    if (m_slots)
+        entry = m_table[_probe(str, len, hash_bytes(str, len))];
+    pthread_rwlock_unlock(&m_lock);
+
+    return Symbol(entry);
+}
+
+size_t InternPool::len() const
+{
+    size_t len;
+
+    pthread_rwlock_rdlock(&m_lock);
+    len = m_len;
+    pthread_rwlock_unlock(&m_lock);
+
+    return len;
+}
+
+size_t InternPool::_probe(char const* str, size_t len, size_t hash) const
+{
+    size_t mask = m_slots - 1;
+    size_t slot = hash & mask;
+
+    while (m_table[slot]) {
+        InternEntry* entry = m_table[slot];
+
+        if (entry->hash == hash && entry->len == len
+            && !memcmp(entry->data, str, len))
+            break;
+
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+InternEntry* InternPool::_new_entry(char const* str, size_t len, size_t hash)
+{
+    InternEntry* entry;
+    size_t       bytes;
+
+    // Keep the entries aligned, because they start with the hash.
+    bytes = offsetof(InternEntry, data) + len + 1;
+    bytes = (bytes + alignof(InternEntry) - 1) & ~(alignof(InternEntry) - 1);
+
+    if (m_chunk_used + bytes > m_chunk_size) {
+        size_t header = alignof(InternEntry) > sizeof(char*)
+            ? alignof(InternEntry) : sizeof(char*);
+        size_t size = header + bytes > CG_INTERN_CHUNK
+            ? header + bytes : CG_INTERN_CHUNK;
+        char*  chunk = (char *) malloc(size);
+
+        memcpy(chunk, &m_chunk, sizeof(char*));
+        m_chunk      = chunk;
+        m_chunk_used = header;
+        m_chunk_size = size;
+    }
+
+    entry = (InternEntry *) (m_chunk + m_chunk_used);
+    m_chunk_used += bytes;
+
+    entry->hash = hash;
+    entry->len  = len;
+    memcpy(entry->data, str, len);
+    entry->data[len] = 0;
+
+    return entry;
+}
+
+void InternPool::_grow()
+{
+    InternEntry** old_table = m_table;
+    size_t        old_slots = m_slots;
+
+    m_slots = m_slots ? m_slots * 2 : 64;
+    m_table = (InternEntry **) calloc(m_slots, sizeof(InternEntry*));
+
+    // The hashes are stored in the entries, so only the slots need to be
+    // recomputed.
+    for (size_t i = 0; i < old_slots; i++) {
+        InternEntry* entry = old_table[i];
+        if (!entry)
+            continue;
+
+        size_t slot = entry->hash & (m_slots - 1);
+        while (m_table[slot])
+            slot = (slot + 1) & (m_slots - 1);
+        m_table[slot] = entry;
+    }
+
+    free(old_table);
+}
+
+InternPool& intern_pool()
+{
+    static InternPool pool;
+    return pool;
+}
+
+Symbol intern(char const* str)
+{
+    return intern_pool().intern(str);
+}
+
+Symbol intern(char const* str, size_t len)
+{
+    return intern_pool().intern(str, len);
+}
+
+Symbol intern(String const& str)
+{
+    return intern_pool().intern(str);
+}
+
+String::String(Symbol const& value) : String()
+{
+    append(value.get(), value.len());
+}
+
+_CG_END
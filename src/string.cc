@@ -4,6 +4,7 @@
  * Copyright (C) 2021-2022 bellrise
  */
 #include <generics/string.h>
+#include <generics/alloc.h>
 #include <string.h>
 #include <malloc.h>
 
@@ -11,7 +12,7 @@ _CG_BEGIN
 
 String::String() : m_size(0), m_len(0), m_val(nullptr) {}
 
-String::String(char_type const* str) : m_val(nullptr)
+String::String(char_type const* str) : m_size(0), m_len(0), m_val(nullptr)
 {
     size_t size;
 
@@ -31,8 +32,13 @@ String::String(String const& str)
     // The copy constructor also needs to copy the m_val allocation.
     m_len = str.m_len;
     m_size = str.m_size;
+    m_val = nullptr;
 
-    m_val = (char_type *) malloc(m_size);
+    // Empty strings have no allocation, see get().
+    if (!m_size)
+        return;
+
+    m_val = (char_type *) mem_alloc(m_size);
     memcpy(m_val, str.m_val, m_len);
     m_val[m_len] = 0;
 }
@@ -67,6 +73,7 @@ String::String(char_type value) : m_val(nullptr)
     _alloc(1);
     m_len = 1;
     m_val[0] = value;
+    m_val[1] = 0;
 }
 
 String::String(size_t value) : m_val(nullptr)
@@ -76,6 +83,8 @@ String::String(size_t value) : m_val(nullptr)
     assign(buf);
 }
 
+String::String(Printable const& value) : String(value.as_string()) {}
+
 String::~String()
 {
     _free();
@@ -114,6 +123,10 @@ bool String::equals(String const& other) const
     if (m_len != other.m_len)
         return false;
 
+    // Empty strings may have no allocation at all.
+    if (!m_len)
+        return true;
+
     return strncmp(m_val, other.m_val, m_size) == 0;
 }
 
@@ -121,16 +134,28 @@ String String::copy() const
 {
     String str;
 
+    if (!m_size)
+        return str;
+
     str.m_len  = m_len;
     str.m_size = m_size;
 
     // Copy the string contents
-    str.m_val = (char_type *) malloc(m_size);
-    strncpy(str.m_val, m_val, m_len);
+    str.m_val = (char_type *) mem_alloc(m_size);
+    memcpy(str.m_val, m_val, m_len);
+    str.m_val[m_len] = 0;
 
     return str;
 }
 
+void String::reserve(size_t len)
+{
+    if (len < m_size)
+        return;
+
+    _alloc(len);
+}
+
 void String::append(String const& other)
 {
     append(other.m_val);
@@ -146,18 +171,19 @@ void String::append(char_type const* other)
 
 void String::append(char_type const* other, size_t len)
 {
-    if (!other)
+    if (!other || !len)
         return;
 
     // Append a C-style string to this string. If the string cannot fit, it
     // will allocate another CG_STRING_ALLOC_G * n bytes to fit the string.
     if (!m_size)
-        _alloc(strlen(other));
+        _alloc(len);
     else if (len > m_size - m_len - 1)
         _alloc(m_len + len);
 
-    strncpy(m_val + m_len, other, len);
+    memcpy(m_val + m_len, other, len);
     m_len += len;
+    m_val[m_len] = 0;
 }
 
 void String::assign(String const& other)
@@ -199,12 +225,26 @@ bool String::operator==(String const& other) const
     return equals(other);
 }
 
+bool String::operator<(String const& other) const
+{
+    int diff;
+
+    diff = memcmp(get(), other.get(), m_len < other.m_len ? m_len : other.m_len);
+    if (diff)
+        return diff < 0;
+
+    return m_len < other.m_len;
+}
+
 String String::operator+(String const& other) const
 {
     // Because this may be used outside of the assignment operator, it needs
-    // to return a new copy of the string.
-    String new_str(m_val);
-    new_str.append(other);
+    // to return a new copy of the string. The final length is known, so the
+    // new string is allocated only once.
+    String new_str;
+    new_str.reserve(m_len + other.m_len);
+    new_str.append(m_val, m_len);
+    new_str.append(other.m_val, other.m_len);
     return new_str;
 }
 
@@ -241,7 +281,7 @@ void String::_alloc(size_t bytes)
     alloc_size += CG_STRING_ALLOC_G;
 
     m_size = alloc_size;
-    m_val = (char_type *) realloc(m_val, m_size);
+    m_val = (char_type *) mem_realloc(m_val, m_size);
     m_val[m_size-1] = 0;
 }
 
@@ -249,7 +289,7 @@ void String::_free()
 {
     m_len  = 0;
     m_size = 0;
-    free(m_val);
+    mem_free(m_val);
     m_val  = nullptr;
 }
 
@@ -0,0 +1,339 @@
+/*
+ * Clean Generics
+ *
+ * Copyright (C) 2021-2022 bellrise
+ */
+#include <generics/string_array.h>
+#include <string.h>
+#include <malloc.h>
+
+_CG_BEGIN
+
+// Compare two strings by their bytes, the same way as String::operator<.
+static bool _less(char const* a, size_t a_len, char const* b, size_t b_len)
+{
+    int diff = memcmp(a, b, a_len < b_len ? a_len : b_len);
+
+    if (diff)
+        return diff < 0;
+
+    return a_len < b_len;
+}
+
+StringArray::StringArray()
+    : m_len(0), m_slots(0), m_bytes(0), m_size(0), m_offsets(nullptr),
+      m_data(nullptr)
+{ }
+
+StringArray::StringArray(StringArray const& other) : StringArray()
+{
+    if (!other.m_len)
+        return;
+
+    _alloc(other.m_len, other.m_bytes);
+    memcpy(m_offsets, other.m_offsets, (other.m_len + 1) * sizeof(size_t));
+    memcpy(m_data, other.m_data, other.m_bytes);
+
+    m_len   = other.m_len;
+    m_bytes = other.m_bytes;
+}
+
+StringArray::StringArray(StringArray&& other) noexcept
+    : m_len(other.m_len), m_slots(other.m_slots), m_bytes(other.m_bytes),
+      m_size(other.m_size), m_offsets(other.m_offsets), m_data(other.m_data)
+{
+    other.m_len     = 0;
+    other.m_slots   = 0;
+    other.m_bytes   = 0;
+    other.m_size    = 0;
+    other.m_offsets = nullptr;
+    other.m_data    = nullptr;
+}
+
+StringArray::~StringArray()
+{
+    clear();
+}
+
+size_t StringArray::len() const
+{
+    return m_len;
+}
+
+size_t StringArray::len(size_t index) const
+{
+    if (index >= m_len)
+        throw "Index is out of bounds";
+
+    return m_offsets[index + 1] - m_offsets[index] - 1;
+}
+
+size_t StringArray::bytes() const
+{
+    return m_bytes;
+}
+
+void StringArray::append(char_type const* str)
+{
+    append(str, str ? strlen(str) : 0);
+}
+
+void StringArray::append(char_type const* str, size_t len)
+{
+    _alloc(m_len + 1, m_bytes + len + 1);
+
+    if (len)
+        memcpy(m_data + m_bytes, str, len);
+
+    m_bytes += len;
+    m_data[m_bytes++] = 0;
+    m_offsets[++m_len] = m_bytes;
+}
+
+void StringArray::append(String const& str)
+{
+    append(str.get(), str.len());
+}
+
+StringArray::char_type const* StringArray::get(size_t index) const
+{
+    if (index >= m_len)
+        throw "Index is out of bounds";
+
+    return m_data + m_offsets[index];
+}
+
+String StringArray::string(size_t index) const
+{
+    String result;
+
+    result.reserve(len(index));
+    result.append(get(index), len(index));
+
+    return result;
+}
+
+void StringArray::clear()
+{
+    free(m_offsets);
+    free(m_data);
+
+    m_len     = 0;
+    m_slots   = 0;
+    m_bytes   = 0;
+    m_size    = 0;
+    m_offsets = nullptr;
+    m_data    = nullptr;
+}
+
+void StringArray::set_size(size_t strings, size_t chars)
+{
+    // Each string also needs room for its null byte.
+    _alloc(m_len + strings, m_bytes + chars + strings);
+}
+
+Array<size_t> StringArray::sort_order() const
+{
+    Array<size_t> order;
+    size_t*       from;
+    size_t*       to;
+    size_t*       tmp;
+
+    if (!m_len)
+        return order;
+
+    // Bottom-up merge sort over the indices, which is stable. Each pass merges
+    // runs from one index buffer into the other.
+    from = (size_t *) malloc(m_len * sizeof(size_t));
+    to   = (size_t *) malloc(m_len * sizeof(size_t));
+
+    for (size_t i = 0; i < m_len; i++)
+        from[i] = i;
+
+    for (size_t width = 1; width < m_len; width *= 2) {
+        for (size_t start = 0; start < m_len; start += 2 * width) {
+            size_t mid  = start + width < m_len ? start + width : m_len;
+            size_t stop = start + 2 * width < m_len ? start + 2 * width : m_len;
+            size_t a    = start;
+            size_t b    = mid;
+            size_t out  = start;
+
+            while (a < mid && b < stop) {
+                size_t ia = from[a];
+                size_t ib = from[b];
+
+                if (_less(get(ib), len(ib), get(ia), len(ia)))
+                    to[out++] = from[b++];
+                else
+                    to[out++] = from[a++];
+            }
+
+            while (a < mid)
+                to[out++] = from[a++];
+            while (b < stop)
+                to[out++] = from[b++];
+        }
+
+        tmp  = from;
+        from = to;
+        to   = tmp;
+    }
+
+    order.set_size(m_len);
+    for (size_t i = 0; i < m_len; i++)
+        order.append(from[i]);
+
+    free(from);
+    free(to);
+    return order;
+}
+
+StringArray StringArray::permute(Array<size_t> const& order) const
+{
+    StringArray result;
+    size_t      total = 0;
+
+    for (size_t index : order) {
+        if (index >= m_len)
+            throw "Index is out of bounds";
+        total += m_offsets[index + 1] - m_offsets[index];
+    }
+
+    result._alloc(order.len(), total);
+
+    for (size_t index : order) {
+        size_t bytes = m_offsets[index + 1] - m_offsets[index];
+
+        memcpy(result.m_data + result.m_bytes, m_data + m_offsets[index], bytes);
+        result.m_bytes += bytes;
+        result.m_offsets[++result.m_len] = result.m_bytes;
+    }
+
+    return result;
+}
+
+void StringArray::sort()
+{
+    StringArray sorted = permute(sort_order());
+    operator=((StringArray&&) sorted);
+}
+
+StringArray StringArray::select(BitArray const& mask) const
+{
+    StringArray result;
+    size_t      strings = 0;
+    size_t      total   = 0;
+
+    if (mask.len() != m_len)
+        throw "Mask length differs from the array length";
+
+    mask.for_each([&] (size_t index) {
+        total += m_offsets[index + 1] - m_offsets[index];
+        strings++;
+    });
+
+    result._alloc(strings, total);
+
+    mask.for_each([&] (size_t index) {
+        size_t bytes = m_offsets[index + 1] - m_offsets[index];
+
+        memcpy(result.m_data + result.m_bytes, m_data + m_offsets[index], bytes);
+        result.m_bytes += bytes;
+        result.m_offsets[++result.m_len] = result.m_bytes;
+    });
+
+    return result;
+}
+
+String StringArray::as_string() const
+{
+    String result;
+
+    if (!m_len)
+        return String("[]");
+
+    // The bytes include a null byte for each string, so one more byte per
+    // string is enough room for the brackets and ", " separators.
+    result.reserve(m_bytes + m_len + 2);
+    result.append("[", 1);
+
+    for (size_t i = 0; i < m_len; i++) {
+        if (i)
+            result.append(", ", 2);
+        result.append(get(i), len(i));
+    }
+
+    result.append("]", 1);
+    return result;
+}
+
+StringArray::char_type const* StringArray::operator[](size_t index) const
+{
+    return get(index);
+}
+
+void StringArray::operator+=(char_type const* str)
+{
+    append(str);
+}
+
+void StringArray::operator+=(String const& str)
+{
+    append(str);
+}
+
+void StringArray::operator=(StringArray const& other)
+{
+    if (this == &other)
+        return;
+
+    StringArray copied(other);
+    operator=((StringArray&&) copied);
+}
+
+void StringArray::operator=(StringArray&& other)
+{
+    clear();
+
+    m_len     = other.m_len;
+    m_slots   = other.m_slots;
+    m_bytes   = other.m_bytes;
+    m_size    = other.m_size;
+    m_offsets = other.m_offsets;
+    m_data    = other.m_data;
+
+    other.m_len     = 0;
+    other.m_slots   = 0;
+    other.m_bytes   = 0;
+    other.m_size    = 0;
+    other.m_offsets = nullptr;
+    other.m_data    = nullptr;
+}
+
+void StringArray::_alloc(size_t strings, size_t bytes)
+{
+    size_t alloc_size;
+
+    // The offsets buffer has one more slot than there are strings.
+    if (strings + 1 > m_slots) {
+        alloc_size = m_slots ? m_slots : CG_ARRAY_ALLOC_G;
+        while (alloc_size < strings + 1)
+            alloc_size *= 2;
+
+        m_offsets = (size_t *) realloc(m_offsets, alloc_size * sizeof(size_t));
+        if (!m_slots)
+            m_offsets[0] = 0;
+        m_slots = alloc_size;
+    }
+
+    if (bytes > m_size) {
+        alloc_size = m_size ? m_size : CG_STRING_ALLOC_G;
+        while (alloc_size < bytes)
+            alloc_size *= 2;
+
+        m_data = (char_type *) realloc(m_data, alloc_size);
+        m_size = alloc_size;
+    }
+}
+
+_CG_END
@@ -0,0 +1,347 @@
+/*
+ * Clean Generics
+ *
+ * Copyright (C) 2021-2022 bellrise
+ *
+ * UTF-8 validation & decoding.
+ */
+#include <generics/string.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+# define CG_UTF8_X86
+# include <emmintrin.h>
+# include <tmmintrin.h>
+#endif
+
+_CG_BEGIN
+
+typedef unsigned char byte;
+
+// Length of the sequence started by a lead byte, or 0 if the byte cannot
+// start a sequence.
+static size_t _sequence_len(byte lead)
+{
+    if (lead < 0x80)
+        return 1;
+    if (lead < 0xC2)
+        return 0;
+    if (lead < 0xE0)
+        return 2;
+    if (lead < 0xF0)
+        return 3;
+    if (lead < 0xF5)
+        return 4;
+    return 0;
+}
+
+// Decode a single sequence, returning its width or 0 if it is invalid.
+static size_t _decode_one(byte const* str, size_t left, unsigned int& codepoint)
+{
+    size_t width = _sequence_len(str[0]);
+
+    if (!width || width > left)
+        return 0;
+
+    if (width == 1) {
+        codepoint = str[0];
+        return 1;
+    }
+
+    for (size_t i = 1; i < width; i++) {
+        if ((str[i] & 0xC0) != 0x80)
+            return 0;
+    }
+
+    // The second byte has a narrower range after some lead bytes, to reject
+    // overlong encodings, surrogates and values past U+10FFFF.
+    if ((str[0] == 0xE0 && str[1] < 0xA0) || (str[0] == 0xED && str[1] > 0x9F)
+        || (str[0] == 0xF0 && str[1] < 0x90) || (str[0] == 0xF4 && str[1] > 0x8F))
+        return 0;
+
+    codepoint = str[0] & (0x7F >> width);
+    for (size_t i = 1; i < width; i++)
+        codepoint = (codepoint << 6) | (str[i] & 0x3F);
+
+    return width;
+}
+
+static bool _is_valid_scalar(byte const* str, size_t len)
+{
+    unsigned int codepoint;
+    size_t       i = 0;
+
+    while (i < len) {
+        // Skip over ASCII 8 bytes at a time.
+        if (i + 8 <= len) {
+            unsigned long long word;
+            memcpy(&word, str + i, 8);
+            if (!(word & 0x8080808080808080ULL)) {
+                i += 8;
+                continue;
+            }
+        }
+
+        size_t width = _decode_one(str + i, len - i, codepoint);
+        if (!width)
+            return false;
+        i += width;
+    }
+
+    return true;
+}
+
+#ifdef CG_UTF8_X86
+
+//
+// The SSSE3 validator checks 16 bytes at once, based on the algorithm by Keiser
+// & Lemire ("Validating UTF-8 In Less Than One Instruction Per Byte"). Every
+// error is detectable by looking at the high nibble of a byte together with
+// the byte before it, which is done with three 16-entry table lookups. Only
+// the "must be a 3rd/4th continuation byte" rule needs bytes further back.
+//
+
+#define TOO_SHORT       (1 << 0)
+#define TOO_LONG        (1 << 1)
+#define OVERLONG_3      (1 << 2)
+#define TOO_LARGE       (1 << 3)
+#define SURROGATE       (1 << 4)
+#define OVERLONG_2      (1 << 5)
+#define TOO_LARGE_1000  (1 << 6)
+#define OVERLONG_4      (1 << 6)
+#define TWO_CONTS       (1 << 7)
+#define CARRY           (TOO_SHORT | TOO_LONG | TWO_CONTS)
+
+__attribute__((target("ssse3")))
+static __m128i _check_block(__m128i input, __m128i prev_input)
+{
+    __m128i const byte_1_high_table = _mm_setr_epi8(
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+        TOO_SHORT | OVERLONG_2,
+        TOO_SHORT,
+        TOO_SHORT | OVERLONG_3 | SURROGATE,
+        TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+
+    __m128i const byte_1_low_table = _mm_setr_epi8(
+        CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+        CARRY | OVERLONG_2,
+        CARRY,
+        CARRY,
+        CARRY | TOO_LARGE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000);
+
+    __m128i const byte_2_high_table = _mm_setr_epi8(
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+
+    __m128i const nibble = _mm_set1_epi8(0x0F);
+    __m128i prev1, prev2, prev3;
+    __m128i byte_1_high, byte_1_low, byte_2_high;
+    __m128i special, must_be_cont;
+
+    prev1 = _mm_alignr_epi8(input, prev_input, 15);
+    prev2 = _mm_alignr_epi8(input, prev_input, 14);
+    prev3 = _mm_alignr_epi8(input, prev_input, 13);
+
+    byte_1_high = _mm_shuffle_epi8(byte_1_high_table,
+        _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+    byte_1_low  = _mm_shuffle_epi8(byte_1_low_table,
+        _mm_and_si128(prev1, nibble));
+    byte_2_high = _mm_shuffle_epi8(byte_2_high_table,
+        _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+
+    special = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+    // Bytes two and three after a 3 or 4-byte lead must be continuations,
+    // which the lookups above mark with TWO_CONTS. Saturating subtraction
+    // leaves the high bit set only for 111_____ and 1111____ respectively.
+    must_be_cont = _mm_or_si128(
+        _mm_subs_epu8(prev2, _mm_set1_epi8((char) (0xE0 - 0x80))),
+        _mm_subs_epu8(prev3, _mm_set1_epi8((char) (0xF0 - 0x80))));
+    must_be_cont = _mm_and_si128(must_be_cont, _mm_set1_epi8((char) 0x80));
+
+    return _mm_xor_si128(must_be_cont, special);
+}
+
+__attribute__((target("ssse3")))
+static bool _is_valid_ssse3(byte const* str, size_t len)
+{
+    // Any lead byte in the last three positions of a block needs the next
+    // block to complete it. Subtracting these limits is non-zero there.
+    __m128i const incomplete_max = _mm_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char) (0xF0 - 1), (char) (0xE0 - 1), (char) (0xC0 - 1));
+
+    __m128i error      = _mm_setzero_si128();
+    __m128i prev_input = _mm_setzero_si128();
+    __m128i incomplete = _mm_setzero_si128();
+    byte    tail[16];
+    size_t  i;
+
+    for (i = 0; i + 16 <= len; i += 16) {
+        __m128i input = _mm_loadu_si128((__m128i const*) (str + i));
+
+        // A block of ASCII is only an error if the previous block left a
+        // sequence unfinished.
+        if (!_mm_movemask_epi8(input)) {
+            error = _mm_or_si128(error, incomplete);
+            incomplete = _mm_setzero_si128();
+        } else {
+            error = _mm_or_si128(error, _check_block(input, prev_input));
+            incomplete = _mm_subs_epu8(input, incomplete_max);
+        }
+
+        prev_input = input;
+    }
+
+    // The tail is padded with zeros, which also catches a sequence cut off at
+    // the end of the string, as a lead byte followed by ASCII.
+    memset(tail, 0, sizeof(tail));
+    memcpy(tail, str + i, len - i);
+    error = _mm_or_si128(error,
+        _check_block(_mm_loadu_si128((__m128i const*) tail), prev_input));
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+}
+
+#endif
+
+bool utf8_is_ascii(char const* str, size_t len)
+{
+    size_t i = 0;
+
+#ifdef CG_UTF8_X86
+    // OR 64 bytes together, so the high bits only need to be checked once.
+    for (; i + 64 <= len; i += 64) {
+        __m128i a = _mm_loadu_si128((__m128i const*) (str + i));
+        __m128i b = _mm_loadu_si128((__m128i const*) (str + i + 16));
+        __m128i c = _mm_loadu_si128((__m128i const*) (str + i + 32));
+        __m128i d = _mm_loadu_si128((__m128i const*) (str + i + 48));
+
+        if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d))))
+            return false;
+    }
+#endif
+
+    for (; i + 8 <= len; i += 8) {
+        unsigned long long word;
+        memcpy(&word, str + i, 8);
+        if (word & 0x8080808080808080ULL)
+            return false;
+    }
+
+    for (; i < len; i++) {
+        if ((byte) str[i] >= 0x80)
+            return false;
+    }
+
+    return true;
+}
+
+bool utf8_is_valid(char const* str, size_t len)
+{
+#ifdef CG_UTF8_X86
+    static bool const has_ssse3 = __builtin_cpu_supports("ssse3");
+
+    if (has_ssse3)
+        return _is_valid_ssse3((byte const*) str, len);
+#endif
+
+    return _is_valid_scalar((byte const*) str, len);
+}
+
+bool _utf8_is_valid_scalar(char const* str, size_t len)
+{
+    return _is_valid_scalar((byte const*) str, len);
+}
+
+size_t utf8_codepoint_count(char const* str, size_t len)
+{
+    size_t count = 0;
+    size_t i     = 0;
+
+#ifdef CG_UTF8_X86
+    // Continuation bytes are 0x80-0xBF, which is -128 to -65 as signed bytes,
+    // so every byte greater than -65 starts a new code point.
+    __m128i const limit = _mm_set1_epi8(-65);
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i input = _mm_loadu_si128((__m128i const*) (str + i));
+        count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpgt_epi8(input, limit)));
+    }
+#endif
+
+    for (; i < len; i++) {
+        if (((byte) str[i] & 0xC0) != 0x80)
+            count++;
+    }
+
+    return count;
+}
+
+CodepointIterator::CodepointIterator(char const* ptr, char const* end)
+    : m_ptr(ptr), m_end(end), m_codepoint(0), m_width(0)
+{
+    _decode();
+}
+
+CodepointIterator& CodepointIterator::operator++()
+{
+    m_ptr += m_width;
+    _decode();
+    return *this;
+}
+
+void CodepointIterator::_decode()
+{
+    if (m_ptr >= m_end) {
+        m_codepoint = 0;
+        m_width     = 0;
+        return;
+    }
+
+    m_width = _decode_one((byte const*) m_ptr, m_end - m_ptr, m_codepoint);
+    if (!m_width) {
+        m_codepoint = 0xFFFD;
+        m_width     = 1;
+    }
+}
+
+bool String::is_ascii() const
+{
+    return utf8_is_ascii(get(), m_len);
+}
+
+bool String::is_valid_utf8() const
+{
+    return utf8_is_valid(get(), m_len);
+}
+
+size_t String::codepoint_count() const
+{
+    return utf8_codepoint_count(get(), m_len);
+}
+
+Codepoints String::codepoints() const
+{
+    return Codepoints(get(), m_len);
+}
+
+_CG_END
@@ -0,0 +1,541 @@
+/*
+ * Clean Generics
+ *
+ * Copyright (C) 2021-2022 bellrise
+ *
+ * Tests, built & run with `make test`.
+ */
+#include <generics.h>
+#include <generics/array.h>
+#include <generics/intern.h>
+#include <generics/alloc.h>
+#include <generics/format.h>
+#include <generics/fixed_array.h>
+#include <generics/fixed_string.h>
+#include <generics/sorted_map.h>
+#include <generics/bit_array.h>
+#include <generics/string_array.h>
+#include <generics/small_array.h>
+#include <generics/concurrent_array.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace generic;
+
+static int failed = 0;
+
+#define CHECK(expr)                                                         \
+    do {                                                                    \
+        if (!(expr)) {                                                      \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+            failed++;                                                       \
+        }                                                                   \
+    } while (0)
+
+// Small deterministic random numbers, so failures can be reproduced.
+static unsigned int random_state = 1;
+
+static unsigned int next_random()
+{
+    random_state = random_state * 1103515245 + 12345;
+    return random_state >> 8;
+}
+
+static void test_fixed()
+{
+    constexpr FixedArray<int, 4> numbers(1, 2, 3);
+    static_assert(numbers.len() == 3 && numbers.sum() == 6, "FixedArray");
+
+    constexpr FixedString name = "generics";
+    constexpr auto full = name + "-fixed";
+    static_assert(full.len() == 14 && full[8] == '-', "FixedString");
+
+    FixedArray<int, 2> full_array(1, 2);
+    bool threw = false;
+    try {
+        full_array.append(3);
+    } catch (char const*) {
+        threw = true;
+    }
+
+    CHECK(threw);
+    CHECK(String(full).equals("generics-fixed"));
+    CHECK(numbers.as_string().equals("[1, 2, 3]"));
+}
+
+// Compare the map against a plain array of keys 0 to 199 after random inserts
+// & erases, checking the lookups and all the bound queries.
+static void test_sorted_map()
+{
+    SortedMap<int, int> map;
+    int                 values[200];
+    bool                present[200];
+
+    for (int i = 0; i < 200; i++)
+        present[i] = false;
+
+    for (int round = 0; round < 20000; round++) {
+        int key = next_random() % 200;
+
+        if (next_random() % 3) {
+            CHECK(map.insert(key, round) != present[key]);
+            present[key] = true;
+            values[key]  = round;
+        } else {
+            CHECK(map.erase(key) == present[key]);
+            present[key] = false;
+        }
+    }
+
+    size_t expected_len = 0;
+    for (int key = 0; key < 200; key++) {
+        expected_len += present[key];
+        CHECK(map.contains(key) == present[key]);
+        if (present[key])
+            CHECK(*map.find(key) == values[key]);
+    }
+    CHECK(map.len() == expected_len);
+
+    for (int key = -1; key <= 200; key++) {
+        int lower = key < 0 ? 0 : key;
+        int upper = key + 1;
+        int floor = key > 199 ? 199 : key;
+
+        while (lower < 200 && !present[lower])
+            lower++;
+        while (upper < 200 && !present[upper])
+            upper++;
+        while (floor >= 0 && !present[floor])
+            floor--;
+
+        auto it = map.lower_bound(key);
+        CHECK(lower == 200 ? it == map.end() : it.key() == lower);
+        it = map.upper_bound(key);
+        CHECK(upper >= 200 ? it == map.end() : it.key() == upper);
+        it = map.floor(key);
+        CHECK(floor < 0 ? it == map.end() : it.key() == floor);
+    }
+
+    // Iteration is in key order.
+    int    previous = -1;
+    size_t seen     = 0;
+    for (auto item : map) {
+        CHECK(item.key > previous);
+        previous = item.key;
+        seen++;
+    }
+    CHECK(seen == expected_len);
+
+    // Bulk loading & copying give the same map.
+    SortedMap<int, int> loaded(map.keys(), map.values());
+    SortedMap<int, int> copied(loaded);
+    CHECK(copied.len() == map.len());
+    CHECK(copied.as_string().equals(map.as_string()));
+}
+
+static void test_format()
+{
+    String name = "bob";
+
+    CHECK(format("{} is {} years, {}", name, 42, -7).equals("bob is 42 years, -7"));
+    CHECK(format("{}{}", 'x', true).equals("xtrue"));
+    CHECK(format("{}", 1.5).equals("1.500000"));
+    CHECK(format("{}", 1e40).len() == 48);
+    CHECK(format("no args").equals("no args"));
+    CHECK(CG_FORMAT("[{}] {}", 18446744073709551615ULL, "end")
+        .equals("[18446744073709551615] end"));
+
+    bool threw = false;
+    try {
+        format("{} {}", 1);
+    } catch (char const*) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+static void test_utf8()
+{
+    char const* valid[] = {
+        "", "ascii only", "\xC3\xA9t\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80",
+        "\xEF\xBF\xBD", "\xF4\x8F\xBF\xBF"
+    };
+    char const* invalid[] = {
+        "\x80", "\xC3", "\xC0\xAF", "\xE0\x80\xAF", "\xED\xA0\x80",
+        "\xF4\x90\x80\x80", "\xF8\x88\x80\x80\x80", "abc\xE2\x82"
+    };
+
+    for (char const* str : valid) {
+        CHECK(utf8_is_valid(str, strlen(str)));
+        CHECK(_utf8_is_valid_scalar(str, strlen(str)));
+    }
+
+    for (char const* str : invalid) {
+        CHECK(!utf8_is_valid(str, strlen(str)));
+        CHECK(!_utf8_is_valid_scalar(str, strlen(str)));
+    }
+
+    // The SIMD path works on blocks of 16 bytes, so compare it against the
+    // scalar path on random text of different lengths. The text is built out
+    // of whole sequences, and every other one gets a random byte replaced.
+    static char const* sequences[] = {
+        "a", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xED\x9F\xBF"
+    };
+    char   buf[128];
+    size_t valid_count = 0;
+
+    for (int round = 0; round < 20000; round++) {
+        size_t target = next_random() % 100;
+        size_t len    = 0;
+
+        while (len < target) {
+            char const* seq = sequences[next_random() % 5];
+            memcpy(buf + len, seq, strlen(seq));
+            len += strlen(seq);
+        }
+
+        if (len && round % 2)
+            buf[next_random() % len] = (char) (next_random() & 0xFF);
+
+        valid_count += _utf8_is_valid_scalar(buf, len);
+        CHECK(utf8_is_valid(buf, len) == _utf8_is_valid_scalar(buf, len));
+    }
+    CHECK(valid_count > 10000 && valid_count < 20000);
+
+    String text = "z\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80";
+    size_t count = 0;
+    for (unsigned int codepoint : text.codepoints())
+        count += codepoint > 0;
+
+    CHECK(text.is_valid_utf8());
+    CHECK(!text.is_ascii());
+    CHECK(text.codepoint_count() == 4);
+    CHECK(count == 4);
+}
+
+static void test_bit_array()
+{
+    Array<int> numbers;
+    for (int i = 0; i < 300; i++)
+        numbers.append((int) (next_random() % 1000));
+
+    BitArray even  = numbers.mask([] (int& n) { return n % 2 == 0; });
+    BitArray small = numbers.mask([] (int& n) { return n < 500; });
+    BitArray both  = even & small;
+
+    size_t expected = 0;
+    for (size_t i = 0; i < numbers.len(); i++)
+        expected += numbers[i] % 2 == 0 && numbers[i] < 500;
+
+    CHECK(both.len() == 300);
+    CHECK(both.count() == expected);
+    CHECK((both | ~both).count() == 300);
+    CHECK((even ^ even).count() == 0);
+
+    Array<int> selected = numbers.select(both);
+    Array<int> filtered = numbers.filter([] (int& n) {
+        return n % 2 == 0 && n < 500;
+    });
+
+    CHECK(selected.len() == filtered.len());
+    for (size_t i = 0; i < selected.len(); i++)
+        CHECK(selected[i] == filtered[i]);
+
+    size_t walked = 0;
+    for (size_t i = both.find_first(); i < both.len(); i = both.find_next(i + 1))
+        walked++;
+    CHECK(walked == expected);
+}
+
+static void test_string_array()
+{
+    StringArray words;
+
+    words.append("pear");
+    words.append("apple");
+    words.append("");
+    words.append("fig");
+    words.append("apple");
+    words.sort();
+
+    CHECK(words.len() == 5);
+    CHECK(words.as_string().equals("[, apple, apple, fig, pear]"));
+
+    StringArray longer = words.filter([] (char const*, size_t len) {
+        return len > 3;
+    });
+
+    CHECK(longer.len() == 3);
+    CHECK(longer.string(2).equals("pear"));
+    CHECK(longer.len(0) == 5);
+}
+
+static void test_intern()
+{
+    Symbol a = intern("name");
+    Symbol b = intern(String("na") + "me");
+
+    CHECK(a == b);
+    CHECK(a != intern("other"));
+    CHECK(a.len() == 4 && !strcmp(a.get(), "name"));
+    CHECK(intern_pool().find("name", 4) == a);
+    CHECK(intern_pool().find("never interned", 14) == Symbol());
+}
+
+static void test_small_array()
+{
+    SmallArray<int, 4> numbers;
+
+    for (int i = 0; i < 4; i++)
+        numbers.append(i);
+    CHECK(numbers.is_inline());
+
+    numbers.append(4);
+    CHECK(!numbers.is_inline());
+    CHECK(numbers.len() == 5 && numbers[4] == 4);
+
+    // Heap storage is handed to the Array and back without copying.
+    int*       storage = &numbers[0];
+    Array<int> array   = numbers.into_array();
+    CHECK(array.begin() == storage);
+    CHECK(numbers.len() == 0 && numbers.is_inline());
+
+    SmallArray<int, 4> back((Array<int>&&) array);
+    CHECK(&back[0] == storage);
+    CHECK(back.sum() == 10);
+
+    SmallArray<String, 2> strings;
+    strings.append("a");
+    strings.append("b");
+    strings.append("c");
+    CHECK(strings.as_string().equals("[a, b, c]"));
+}
+
+static void* _append_numbers(void* data)
+{
+    ConcurrentArray<size_t>* numbers = (ConcurrentArray<size_t>*) data;
+
+    for (size_t i = 0; i < 10000; i++)
+        numbers->append(i);
+
+    return nullptr;
+}
+
+static void test_concurrent_array()
+{
+    ConcurrentArray<size_t> numbers;
+    pthread_t               threads[4];
+    size_t                  seen[10000] = {};
+
+    for (int i = 0; i < 4; i++)
+        pthread_create(&threads[i], nullptr, _append_numbers, &numbers);
+    for (int i = 0; i < 4; i++)
+        pthread_join(threads[i], nullptr);
+
+    CHECK(numbers.len() == 40000);
+    numbers.for_each([&seen] (size_t& n) { seen[n]++; });
+
+    bool all_four = true;
+    for (size_t i = 0; i < 10000; i++)
+        all_four = all_four && seen[i] == 4;
+    CHECK(all_four);
+
+    Array<size_t> array = numbers.into_array();
+    CHECK(array.len() == 40000);
+    CHECK(numbers.len() == 0);
+}
+
+static void test_hash_join()
+{
+    Array<int> users;
+    Array<int> orders;
+
+    for (int i = 0; i < 50; i++)
+        users.append(i * 2);
+    for (int i = 0; i < 200; i++)
+        orders.append((int) (next_random() % 100));
+
+    auto joined = users.hash_join(orders, [] (int& user) { return user; },
+                                  [] (int& user) { return user; });
+
+    // Every user id is unique, so each even order matches exactly once.
+    size_t expected = 0;
+    for (size_t i = 0; i < orders.len(); i++)
+        expected += orders[i] % 2 == 0;
+
+    CHECK(joined.left().len() == expected);
+    CHECK(joined.right().len() == expected);
+    for (size_t i = 0; i < joined.left().len(); i++) {
+        CHECK(users[joined.left().begin()[i]]
+            == orders[joined.right().begin()[i]]);
+    }
+}
+
+static void* _free_strings(void* data)
+{
+    Array<String>* strings = (Array<String>*) data;
+
+    strings->clear();
+    return nullptr;
+}
+
+// Strings allocated by one thread and freed by another go back to their
+// owner, see generics/alloc.h.
+static void test_alloc_threads()
+{
+    Array<String> strings;
+    pthread_t     thread;
+
+    for (int i = 0; i < 1000; i++)
+        strings.append(String("string number ") + String(i));
+
+    pthread_create(&thread, nullptr, _free_strings, &strings);
+    pthread_join(thread, nullptr);
+
+    CHECK(strings.len() == 0);
+    for (int i = 0; i < 1000; i++)
+        strings.append(String("again ") + String(i));
+    CHECK(strings[999].equals("again 999"));
+}
+
+// Arrays of trivial types past CG_ARRAY_MMAP_BYTES are backed by their own
+// mapping, which grows with mremap().
+static void test_array_mmap()
+{
+    size_t        amount = 3 * CG_ARRAY_MMAP_BYTES / sizeof(size_t);
+    Array<size_t> numbers;
+
+    numbers.set_size(CG_ARRAY_MMAP_BYTES / sizeof(size_t));
+    for (size_t i = 0; i < amount; i++)
+        numbers.append(i);
+
+    CHECK(numbers.len() == amount);
+    CHECK(numbers.size() * sizeof(size_t) >= amount * sizeof(size_t));
+
+    bool in_order = true;
+    for (size_t i = 0; i < amount; i++)
+        in_order = in_order && numbers[i] == i;
+    CHECK(in_order);
+
+    Array<size_t> copied = numbers;
+    CHECK(copied.len() == amount && copied[amount - 1] == amount - 1);
+
+    SmallArray<size_t, 4> small((Array<size_t>&&) copied);
+    small.append(7);
+    CHECK(small.len() == amount + 1 && small[amount] == 7);
+
+    Array<size_t> back = small.into_array();
+    back.clear();
+    numbers.clear();
+    CHECK(numbers.len() == 0);
+}
+
+// Symbols carry their own hash, so they can be used as keys for the hash
+// based operators on Array.
+static void test_group_by_symbol()
+{
+    Array<Symbol> words;
+
+    words.append(intern("apple"));
+    words.append(intern("pear"));
+    words.append(intern("apple"));
+    words.append(intern("plum"));
+    words.append(intern("apple"));
+
+    auto by_word = words.group_by([] (Symbol& word) { return word; });
+    CHECK(by_word.len() == 3);
+    CHECK(by_word.key(0) == intern("apple"));
+    CHECK(by_word.count(0) == 3);
+    CHECK(by_word.key(1) == intern("pear"));
+    CHECK(by_word.count(1) == 1);
+    CHECK(by_word.key(2) == intern("plum"));
+    CHECK(by_word.as_string().equals("{apple: [apple, apple, apple], "
+                                     "pear: [pear], plum: [plum]}"));
+
+    auto counts = words.count_by([] (Symbol& word) { return word; });
+    CHECK(counts.len() == 3);
+    CHECK(counts.count(0) == 3);
+    CHECK(counts.as_string().equals("{apple: 3, pear: 1, plum: 1}"));
+
+    Array<Symbol> distinct = words.distinct();
+    CHECK(distinct.len() == 3);
+    CHECK(distinct.as_string().equals("[apple, pear, plum]"));
+}
+
+// Symbols are formatted straight from the intern pool, without a temporary
+// String which would be freed before the result is built.
+static void test_format_symbol()
+{
+    Symbol name = intern("world");
+
+    CHECK(format("hello {}!", name).equals("hello world!"));
+    CHECK(CG_FORMAT("{}-{}", name, Symbol()).equals("world-"));
+}
+
+// Runs against both allocators, see the test-allocator target.
+static void test_alloc()
+{
+    void* blocks[8];
+
+    // Zero-byte blocks still need room for the free list link.
+    for (int i = 0; i < 8; i++)
+        blocks[i] = mem_alloc(0);
+    for (int i = 0; i < 8; i++)
+        mem_free(blocks[i]);
+    for (int i = 0; i < 8; i++) {
+        blocks[i] = mem_alloc(0);
+        CHECK(blocks[i] != nullptr);
+        CHECK((size_t) blocks[i] % CG_ALLOC_ALIGN == 0);
+    }
+    for (int i = 0; i < 8; i++)
+        mem_free(blocks[i]);
+
+    char* ptr = (char *) mem_alloc(10);
+    memcpy(ptr, "0123456789", 10);
+    ptr = (char *) mem_realloc(ptr, 100000);
+    CHECK(!memcmp(ptr, "0123456789", 10));
+    ptr = (char *) mem_realloc(ptr, 20);
+    CHECK(!memcmp(ptr, "0123456789", 10));
+    mem_free(ptr);
+
+    // Copies of empty strings, which are copied again when the array grows.
+    Array<String> strings;
+    String        empty;
+
+    for (int i = 0; i < 100; i++)
+        strings.append(empty);
+
+    CHECK(strings.len() == 100);
+    CHECK(strings[99].len() == 0);
+    CHECK(strings[99].get()[0] == 0);
+    CHECK(empty.copy().equals(""));
+    CHECK(String("abc").copy().equals("abc"));
+}
+
+int main()
+{
+    test_fixed();
+    test_sorted_map();
+    test_format();
+    test_format_symbol();
+    test_utf8();
+    test_bit_array();
+    test_string_array();
+    test_intern();
+    test_small_array();
+    test_concurrent_array();
+    test_group_by_symbol();
+    test_hash_join();
+    test_alloc();
+    test_alloc_threads();
+    test_array_mmap();
+
+    if (failed) {
+        printf("%d checks failed\n", failed);
+        return 1;
+    }
+
+    printf("All tests passed\n");
+    return 0;
+}